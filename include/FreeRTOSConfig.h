@@ -7,6 +7,35 @@
 #define portCONFIGURE_TIMER_FOR_RUN_TIME_STATS() 
 #define portGET_RUN_TIME_COUNTER_VALUE()            time_us_64()
 
+// Set by the TICKLESS_IDLE cmake option: the idle task stops SysTick and
+// sleeps until the next timeout on the RP2040 64-bit timer. See src/tickless_idle.c
+#if TICKLESS_IDLE
+#define configUSE_TICKLESS_IDLE 2
+#define configEXPECTED_IDLE_TIME_BEFORE_SLEEP 2
+#define portSUPPRESS_TICKS_AND_SLEEP(xExpectedIdleTime) vPortSuppressTicksAndSleepTimer(xExpectedIdleTime)
+#ifndef __ASSEMBLER__
+#include <stdint.h>
+void vPortSuppressTicksAndSleepTimer(uint32_t xExpectedIdleTime);
+#endif
+#endif
+
+// Context switch accounting for the load monitor, see src/load_monitor.c
+#ifndef __ASSEMBLER__
+void load_monitor_switched_in(void *task);
+void load_monitor_task_deleted(void *task);
+#endif
+#define traceTASK_SWITCHED_IN()             load_monitor_switched_in(pxCurrentTCB)
+#define traceTASK_DELETE(pxTaskToDelete)    load_monitor_task_deleted(pxTaskToDelete)
+
+// Tick handler timing for the benchmarks, see src/tick_stats.c. Only set
+// for the test binary, so production builds keep a bare SysTick handler.
+#if TICK_STATS
+#ifndef __ASSEMBLER__
+void tick_stats_record(void);
+#endif
+#define traceRETURN_xTaskIncrementTick(xSwitchRequired) tick_stats_record()
+#endif
+
 // This example uses a common include to avoid repetition
 #include "FreeRTOSConfig_examples_common.h"
 
@@ -0,0 +1,43 @@
+#ifndef ADAPTIVE_MUTEX_H
+#define ADAPTIVE_MUTEX_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "FreeRTOS.h"
+#include "semphr.h"
+
+// Spin-then-block mutex.
+//
+// A contended take first spins while the holder is running on the other
+// core, since it will often release before a block and context switch would
+// even finish, and falls back to blocking on a FreeRTOS mutex (with priority
+// inheritance) when the spin runs out. The spin limit is learned per lock:
+// twice a moving average of the spins that won the lock, which decays when
+// spinning fails. On the single core port the holder can't be running while
+// we are, so a contended take always blocks straight away.
+
+#define ADAPTIVE_MUTEX_SPIN_MIN 16
+#define ADAPTIVE_MUTEX_SPIN_MAX 4096
+
+typedef struct {
+    uint32_t acquisitions;
+    uint32_t spin_acquired;         // contended takes won by spinning
+    uint32_t blocked;               // contended takes that blocked
+    uint32_t timeouts;
+    uint64_t spins_total;
+    uint32_t spin_estimate;         // learned spins to acquire
+} adaptive_mutex_stats_t;
+
+typedef struct {
+    SemaphoreHandle_t handle;
+    volatile TaskHandle_t owner;    // NULL from just before the give
+    adaptive_mutex_stats_t stats;   // updated while holding the lock
+} adaptive_mutex_t;
+
+bool adaptive_mutex_init(adaptive_mutex_t *mutex);
+void adaptive_mutex_delete(adaptive_mutex_t *mutex);
+BaseType_t adaptive_mutex_take(adaptive_mutex_t *mutex, TickType_t timeout);
+void adaptive_mutex_give(adaptive_mutex_t *mutex);
+void adaptive_mutex_get_stats(const adaptive_mutex_t *mutex, adaptive_mutex_stats_t *stats);
+
+#endif /* ADAPTIVE_MUTEX_H */
@@ -0,0 +1,55 @@
+#ifndef EVENT_LOOP_H
+#define EVENT_LOOP_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "FreeRTOS.h"
+#include "hardware/sync.h"
+#include "pico/async_context_freertos.h"
+
+// Event-driven execution on top of async_context_freertos.
+//
+// Any number of handlers and periodic timers share one FreeRTOS task and one
+// stack. Callbacks run to completion on that task, one at a time, so they
+// must not block. Posting an event is cheap and safe from tasks and ISRs;
+// events posted to a handler before it gets to run are coalesced into a
+// single callback that is told how many arrived.
+
+typedef void (*event_callback_t)(void *user_data, uint32_t events);
+
+typedef struct {
+    async_context_freertos_t context;
+    spin_lock_t *lock;
+} event_loop_t;
+
+typedef struct {
+    async_when_pending_worker_t worker;     // must stay first
+    event_loop_t *loop;
+    event_callback_t callback;
+    void *user_data;
+    volatile uint32_t posted;               // bumped by event_loop_post
+    uint32_t handled;                       // only touched by the loop task
+} event_handler_t;
+
+typedef struct {
+    async_at_time_worker_t worker;          // must stay first
+    event_callback_t callback;
+    void *user_data;
+    uint32_t period_ms;
+} event_timer_t;
+
+bool event_loop_init(event_loop_t *loop, UBaseType_t priority, configSTACK_DEPTH_TYPE stack_size);
+void event_loop_deinit(event_loop_t *loop);
+
+bool event_loop_add_handler(event_loop_t *loop, event_handler_t *handler,
+                            event_callback_t callback, void *user_data);
+void event_loop_remove_handler(event_loop_t *loop, event_handler_t *handler);
+// Queues one event for handler. Safe from any task or ISR.
+void event_loop_post(event_handler_t *handler);
+
+// Calls callback every period_ms, starting period_ms from now.
+bool event_loop_add_timer(event_loop_t *loop, event_timer_t *timer, uint32_t period_ms,
+                          event_callback_t callback, void *user_data);
+void event_loop_remove_timer(event_loop_t *loop, event_timer_t *timer);
+
+#endif /* EVENT_LOOP_H */
@@ -0,0 +1,66 @@
+#ifndef IPC_CHANNEL_H
+#define IPC_CHANNEL_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "pico/sync.h"
+
+// Single-producer/single-consumer message channel between the two cores.
+//
+// Messages live in a ring of fixed-size slots in shared SRAM. The producer
+// reserves a slot, writes the message in place and commits it; the consumer
+// peeks the slot, reads it in place and releases it, so no copy is made on
+// either side. The consumer only sleeps when the ring is empty, and the
+// producer only rings the doorbell when the consumer is actually asleep. A
+// producer blocked on a full ring sleeps the same way, on a second semaphore
+// the consumer only releases when the producer is waiting.
+//
+// The doorbell is a pico_sync semaphore. With configSUPPORT_PICO_SYNC_INTEROP
+// a release from the non-FreeRTOS core is delivered through the SIO FIFO IRQ
+// that the RP2040 port already owns, which wakes the blocked consumer task.
+// Either end may also be a FreeRTOS task on the same core.
+
+// Bytes reserved at the start of every slot for the message length.
+#define IPC_CHANNEL_HEADER_SIZE 4
+
+// Size of the storage needed for slot_count slots of slot_size bytes each.
+#define IPC_CHANNEL_STORAGE_SIZE(slot_size, slot_count) \
+    ((((slot_size) + IPC_CHANNEL_HEADER_SIZE + 3) & ~3u) * (slot_count))
+
+typedef struct {
+    volatile uint32_t head;             // next slot to write, owned by producer
+    volatile uint32_t tail;             // next slot to read, owned by consumer
+    volatile bool consumer_waiting;     // consumer is (about to be) asleep
+    volatile bool producer_waiting;     // producer is (about to be) asleep
+    uint32_t slot_size;                 // usable payload bytes per slot
+    uint32_t slot_stride;               // bytes between slots, header included
+    uint32_t slot_mask;                 // slot_count - 1
+    uint8_t *slots;
+    semaphore_t doorbell;
+    semaphore_t space;
+} ipc_channel_t;
+
+// slot_count must be a power of two and storage must be word aligned and at
+// least IPC_CHANNEL_STORAGE_SIZE(slot_size, slot_count) bytes.
+void ipc_channel_init(ipc_channel_t *ch, void *storage,
+                      uint32_t slot_size, uint32_t slot_count);
+
+// Producer side. Returns a slot of ch->slot_size bytes, or NULL if full.
+void *ipc_channel_reserve(ipc_channel_t *ch);
+// As above, but waits for the consumer to free a slot.
+void *ipc_channel_reserve_blocking(ipc_channel_t *ch);
+// Publishes the reserved slot holding len bytes.
+void ipc_channel_commit(ipc_channel_t *ch, uint32_t len);
+
+// Consumer side. Returns the oldest message and stores its length in len,
+// or NULL if nothing arrived within timeout_us.
+void *ipc_channel_peek(ipc_channel_t *ch, uint32_t *len, uint32_t timeout_us);
+// Hands the slot returned by ipc_channel_peek back to the producer.
+void ipc_channel_release(ipc_channel_t *ch);
+
+static inline uint32_t ipc_channel_count(const ipc_channel_t *ch)
+{
+    return ch->head - ch->tail;
+}
+
+#endif /* IPC_CHANNEL_H */
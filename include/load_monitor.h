@@ -0,0 +1,50 @@
+#ifndef LOAD_MONITOR_H
+#define LOAD_MONITOR_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "FreeRTOS.h"
+#include "task.h"
+
+// CPU load monitor.
+//
+// The context switch hook (traceTASK_SWITCHED_IN, see FreeRTOSConfig.h)
+// charges the time since the last switch to the task that was running, into
+// 1 ms, 100 ms and 1 s windows. Readers get a consistent snapshot through a
+// per-core seqlock, without suspending the scheduler or walking task lists.
+//
+// Each window keeps the time used in the current period and in the previous
+// one, and reports the sliding estimate
+//   current + previous * (time left in the current period) / period
+// in per mille. Tasks are tracked through a thread local storage slot.
+
+#define LOAD_MONITOR_MAX_TASKS 32
+#define LOAD_MONITOR_TLS_INDEX ( configNUM_THREAD_LOCAL_STORAGE_POINTERS - 1 )
+
+typedef enum {
+    LOAD_WINDOW_1MS,
+    LOAD_WINDOW_100MS,
+    LOAD_WINDOW_1S,
+    LOAD_WINDOWS
+} load_window_t;
+
+typedef struct {
+    uint16_t permille[LOAD_WINDOWS];
+    uint64_t total_us;              // since the task was first seen
+} load_snapshot_t;
+
+// Returns false if the task has never run or wasn't given a slot.
+bool load_monitor_get_task(TaskHandle_t task, load_snapshot_t *snapshot);
+// Idle time of a core, in the same units.
+void load_monitor_get_core_idle(UBaseType_t core, load_snapshot_t *snapshot);
+// Tasks currently holding a slot. A deleted task gives its slot back.
+uint32_t load_monitor_tracked_tasks(void);
+// Switches to tasks that found every slot taken, and so aren't tracked.
+uint32_t load_monitor_untracked(void);
+void load_monitor_report(void);
+
+// Kernel hooks, called from FreeRTOSConfig.h trace macros.
+void load_monitor_switched_in(void *task);
+void load_monitor_task_deleted(void *task);
+
+#endif /* LOAD_MONITOR_H */
@@ -0,0 +1,93 @@
+#ifndef RAM_PLACEMENT_H
+#define RAM_PLACEMENT_H
+
+// Hot path placement in SRAM.
+//
+// With -DHOT_PATHS_IN_RAM=ON the build force-includes this header into every
+// C file of the target (see target_hot_paths_in_ram in the top CMakeLists).
+// A section attribute on an earlier declaration carries over to the
+// definition, so the kernel functions below land in .time_critical.*, which
+// the SDK linker script copies to SRAM at boot, without patching the kernel.
+//
+// Our own hot functions opt in with HOT_PATH_FUNC, the same as the SDK's
+// __not_in_flash_func.
+//
+// Only functions with external linkage can be moved this way. The kernel's
+// static helpers on the same paths (prvAddCurrentTaskToDelayedList,
+// prvCopyDataToQueue, prvCopyDataFromQueue, prvUnlockQueue and the like)
+// stay in flash unless the compiler inlines them into a function listed
+// here, so a cache miss can still land in the middle of a block or wake.
+
+#include <stdint.h>
+
+#ifndef HOT_PATHS_IN_RAM
+#define HOT_PATHS_IN_RAM 0
+#endif
+
+#if HOT_PATHS_IN_RAM
+
+#define HOT_PATH_FUNC(func_name) \
+    __attribute__((section(".time_critical." #func_name))) func_name
+
+#define HOT_PATH_SECTION(func_name) \
+    __attribute__((section(".time_critical." #func_name)))
+
+// Spelled with the underlying types so this can precede the kernel headers.
+struct xLIST;
+struct xLIST_ITEM;
+struct xTIME_OUT;
+struct tskTaskControlBlock;
+struct QueueDefinition;
+
+// Ready/delayed/event list handling, under every block and wake.
+void vListInsert(struct xLIST *pxList, struct xLIST_ITEM *pxNewListItem) HOT_PATH_SECTION(vListInsert);
+void vListInsertEnd(struct xLIST *pxList, struct xLIST_ITEM *pxNewListItem) HOT_PATH_SECTION(vListInsertEnd);
+unsigned long uxListRemove(struct xLIST_ITEM *pxItemToRemove) HOT_PATH_SECTION(uxListRemove);
+
+// Scheduler core and tick.
+#if configNUMBER_OF_CORES > 1
+void vTaskSwitchContext(long xCoreID) HOT_PATH_SECTION(vTaskSwitchContext);
+#else
+void vTaskSwitchContext(void) HOT_PATH_SECTION(vTaskSwitchContext);
+#endif
+long xTaskIncrementTick(void) HOT_PATH_SECTION(xTaskIncrementTick);
+void vTaskSuspendAll(void) HOT_PATH_SECTION(vTaskSuspendAll);
+long xTaskResumeAll(void) HOT_PATH_SECTION(xTaskResumeAll);
+long xTaskRemoveFromEventList(const struct xLIST *pxEventList) HOT_PATH_SECTION(xTaskRemoveFromEventList);
+void vTaskPlaceOnEventList(struct xLIST *pxEventList, uint32_t xTicksToWait) HOT_PATH_SECTION(vTaskPlaceOnEventList);
+long xTaskPriorityInherit(struct tskTaskControlBlock *pxMutexHolder) HOT_PATH_SECTION(xTaskPriorityInherit);
+long xTaskPriorityDisinherit(struct tskTaskControlBlock *pxMutexHolder) HOT_PATH_SECTION(xTaskPriorityDisinherit);
+long xTaskCheckForTimeOut(struct xTIME_OUT *pxTimeOut, uint32_t *pxTicksToWait) HOT_PATH_SECTION(xTaskCheckForTimeOut);
+void vTaskInternalSetTimeOutState(struct xTIME_OUT *pxTimeOut) HOT_PATH_SECTION(vTaskInternalSetTimeOutState);
+
+// Critical sections, taken by nearly every kernel call.
+#if configNUMBER_OF_CORES > 1
+void vTaskEnterCritical(void) HOT_PATH_SECTION(vTaskEnterCritical);
+void vTaskExitCritical(void) HOT_PATH_SECTION(vTaskExitCritical);
+#else
+void vPortEnterCritical(void) HOT_PATH_SECTION(vPortEnterCritical);
+void vPortExitCritical(void) HOT_PATH_SECTION(vPortExitCritical);
+#endif
+
+// Port context switch and tick interrupt.
+void xPortPendSVHandler(void) HOT_PATH_SECTION(xPortPendSVHandler);
+void xPortSysTickHandler(void) HOT_PATH_SECTION(xPortSysTickHandler);
+
+// Queue and semaphore take/give.
+long xQueueSemaphoreTake(struct QueueDefinition *xQueue, uint32_t xTicksToWait) HOT_PATH_SECTION(xQueueSemaphoreTake);
+long xQueueGenericSend(struct QueueDefinition *xQueue, const void *pvItemToQueue,
+                       uint32_t xTicksToWait, long xCopyPosition) HOT_PATH_SECTION(xQueueGenericSend);
+long xQueueReceive(struct QueueDefinition *xQueue, void *pvBuffer, uint32_t xTicksToWait) HOT_PATH_SECTION(xQueueReceive);
+long xQueueGiveFromISR(struct QueueDefinition *xQueue, long *pxHigherPriorityTaskWoken) HOT_PATH_SECTION(xQueueGiveFromISR);
+long xQueueGenericSendFromISR(struct QueueDefinition *xQueue, const void *pvItemToQueue,
+                              long *pxHigherPriorityTaskWoken, long xCopyPosition) HOT_PATH_SECTION(xQueueGenericSendFromISR);
+long xQueueReceiveFromISR(struct QueueDefinition *xQueue, void *pvBuffer,
+                          long *pxHigherPriorityTaskWoken) HOT_PATH_SECTION(xQueueReceiveFromISR);
+
+#else
+
+#define HOT_PATH_FUNC(func_name) func_name
+
+#endif
+
+#endif /* RAM_PLACEMENT_H */
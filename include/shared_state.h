@@ -0,0 +1,55 @@
+#ifndef SHARED_STATE_H
+#define SHARED_STATE_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+// Single-writer/multi-reader shared state that readers never block on.
+//
+// seqlock: readers copy the data and retry if a write overlapped the copy.
+// The write runs in a critical section, so a reader can never preempt a
+// half-finished write on its own core and spin on it; keep the data small.
+//
+// rcu_buffer: two copies of the data. Readers pin the current copy and use
+// it in place for as long as they like; the writer fills the other copy and
+// publishes it with a single index flip. Before reusing a copy the writer
+// waits (by sleeping, not spinning) until the readers still on it are done.
+//
+// Both are for tasks; there must only ever be one writer.
+
+typedef struct {
+    volatile uint32_t sequence;     // odd while a write is in progress
+} seqlock_t;
+
+void seqlock_init(seqlock_t *lock);
+// For writers that can't be preempted by a reader anyway (ISRs, kernel
+// hooks) and update in place rather than copy.
+void seqlock_write_begin(seqlock_t *lock);
+void seqlock_write_end(seqlock_t *lock);
+// Returns the sequence to check with seqlock_read_retry once done reading.
+uint32_t seqlock_read_begin(const seqlock_t *lock);
+bool seqlock_read_retry(const seqlock_t *lock, uint32_t sequence);
+void seqlock_write(seqlock_t *lock, void *shared, const void *value, size_t size);
+// Returns the number of retries needed to get a consistent copy.
+uint32_t seqlock_read(const seqlock_t *lock, void *value, const void *shared, size_t size);
+
+typedef struct {
+    void *buffers[2];
+    size_t size;
+    volatile uint32_t current;      // index of the published copy
+    volatile uint32_t readers[2];   // readers pinned to each copy
+} rcu_buffer_t;
+
+void rcu_buffer_init(rcu_buffer_t *rcu, void *buffer0, void *buffer1, size_t size, const void *initial);
+// Pins and returns the published copy; token must be passed to unlock.
+const void *rcu_read_lock(rcu_buffer_t *rcu, uint32_t *token);
+void rcu_read_unlock(rcu_buffer_t *rcu, uint32_t token);
+// Returns the unpublished copy, pre-filled with the published data.
+void *rcu_update_begin(rcu_buffer_t *rcu);
+// Publishes the copy returned by rcu_update_begin.
+void rcu_update_end(rcu_buffer_t *rcu);
+// rcu_update_begin, overwrite with value, rcu_update_end.
+void rcu_publish(rcu_buffer_t *rcu, const void *value);
+
+#endif /* SHARED_STATE_H */
@@ -0,0 +1,32 @@
+#ifndef TICK_STATS_H
+#define TICK_STATS_H
+
+#include <stdint.h>
+
+// Tick interrupt cost.
+//
+// The traceRETURN_xTaskIncrementTick hook (see FreeRTOSConfig.h) reads
+// SysTick as the kernel finishes processing a tick. SysTick reloaded when
+// the interrupt fired, so the count down so far is the whole tick handler
+// up to that point in CPU cycles: exception entry, waking the tasks whose
+// delay ended and the time slicing check. Ticks pended while the scheduler
+// was suspended and replayed later from xTaskResumeAll aren't counted, and
+// neither is the first tick after a tickless idle sleep, whose period was
+// shortened to get back on the tick grid.
+//
+// The hook is only compiled in with TICK_STATS=1, which the test binary
+// sets; elsewhere tick_stats_get reports nothing.
+
+typedef struct {
+    uint32_t ticks;
+    uint32_t cycles_max;
+    uint64_t cycles_total;
+} tick_stats_t;
+
+void tick_stats_get(tick_stats_t *stats);
+void tick_stats_reset(void);
+
+// Kernel hook, called from a FreeRTOSConfig.h trace macro.
+void tick_stats_record(void);
+
+#endif /* TICK_STATS_H */
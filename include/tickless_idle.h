@@ -0,0 +1,34 @@
+#ifndef TICKLESS_IDLE_H
+#define TICKLESS_IDLE_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#ifndef TICKLESS_IDLE
+#define TICKLESS_IDLE 0
+#endif
+
+// Tickless idle for the single core RP2040 port.
+//
+// When built with -DTICKLESS_IDLE=ON the idle task stops SysTick, arms a
+// hardware timer alarm for the next task timeout and sleeps in WFI. On wakeup
+// the kernel tick count is stepped by the whole ticks that passed and SysTick
+// is restarted on the original tick grid. Run time stats keep working as they
+// are clocked from the same 64-bit timer, and the idle task is charged for
+// the time spent asleep.
+
+typedef struct {
+    uint32_t sleeps;            // times the idle task went to sleep
+    uint32_t suppressed_ticks;  // tick interrupts that never happened
+    uint64_t slept_us;          // total time asleep
+} tickless_idle_stats_t;
+
+// Tickless idle can be switched off at runtime to compare against the
+// normal tick. Does nothing when not built in.
+void tickless_idle_set_enabled(bool enabled);
+bool tickless_idle_is_built_in(void);
+void tickless_idle_get_stats(tickless_idle_stats_t *stats);
+// Cheap read of stats.sleeps, for code that runs in the tick interrupt.
+uint32_t tickless_idle_sleep_count(void);
+
+#endif /* TICKLESS_IDLE_H */
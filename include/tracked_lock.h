@@ -0,0 +1,67 @@
+#ifndef TRACKED_LOCK_H
+#define TRACKED_LOCK_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "FreeRTOS.h"
+#include "semphr.h"
+
+// Instrumented mutex/binary semaphore.
+//
+// Every lock is added to the FreeRTOS queue registry under its name, so it
+// shows up by name in debuggers, and to a list that tracked_lock_find and the
+// report walk. Init fails if the registry is full. Each take/give costs two
+// timer reads and a short critical section, which is cheap enough to leave on
+// in production builds.
+//
+// A boost is counted at the give, when the holder finds its priority raised
+// above its base priority by a waiter blocked behind it. A task holding
+// several mutexes at once may have been boosted through another of them.
+//
+// Wait and hold times go into log2 histograms: bucket 0 counts 0 us, bucket i
+// counts [2^(i-1), 2^i) us and the last bucket also everything above it.
+
+#define TRACKED_LOCK_BUCKETS 12
+
+typedef struct {
+    uint32_t acquisitions;
+    uint32_t contended;             // acquisitions that had to wait
+    uint32_t timeouts;              // takes that gave up
+    uint32_t inheritance_boosts;    // holds that ended with the holder boosted
+    uint64_t wait_us_total;
+    uint64_t hold_us_total;
+    uint32_t wait_us_max;
+    uint32_t hold_us_max;
+    uint32_t wait_histogram[TRACKED_LOCK_BUCKETS];
+    uint32_t hold_histogram[TRACKED_LOCK_BUCKETS];
+    TaskHandle_t holder;            // NULL when free
+} tracked_lock_stats_t;
+
+typedef struct tracked_lock {
+    SemaphoreHandle_t handle;
+    const char *name;
+    bool is_mutex;
+    uint64_t acquired_us;
+    tracked_lock_stats_t stats;
+    struct tracked_lock *next;
+} tracked_lock_t;
+
+// A mutex has priority inheritance, a binary semaphore doesn't. The lock
+// starts out free. name must outlive the lock.
+bool tracked_lock_init_mutex(tracked_lock_t *lock, const char *name);
+bool tracked_lock_init_binary(tracked_lock_t *lock, const char *name);
+void tracked_lock_delete(tracked_lock_t *lock);
+
+BaseType_t tracked_lock_take(tracked_lock_t *lock, TickType_t timeout);
+void tracked_lock_give(tracked_lock_t *lock);
+
+// Query API.
+tracked_lock_t *tracked_lock_find(const char *name);
+void tracked_lock_get_stats(const tracked_lock_t *lock, tracked_lock_stats_t *stats);
+void tracked_lock_reset_stats(tracked_lock_t *lock);
+// Prints one line per registered lock.
+void tracked_lock_report(void);
+// Starts a task that calls tracked_lock_report every period_ms.
+TaskHandle_t tracked_lock_start_report_task(uint32_t period_ms, UBaseType_t priority);
+
+#endif /* TRACKED_LOCK_H */
@@ -0,0 +1,100 @@
+#include <string.h>
+#include "adaptive_mutex.h"
+#include "task.h"
+#include "pico/platform.h"
+#include "ram_placement.h"
+
+bool adaptive_mutex_init(adaptive_mutex_t *mutex)
+{
+    mutex->handle = xSemaphoreCreateMutex();
+    mutex->owner = NULL;
+    memset(&mutex->stats, 0, sizeof(mutex->stats));
+    mutex->stats.spin_estimate = ADAPTIVE_MUTEX_SPIN_MIN;
+    return mutex->handle != NULL;
+}
+
+void adaptive_mutex_delete(adaptive_mutex_t *mutex)
+{
+    vSemaphoreDelete(mutex->handle);
+    mutex->handle = NULL;
+}
+
+#if configNUMBER_OF_CORES > 1
+// Spins for the lock while the holder runs on the other core. spins is set
+// to the spins spent, 0 if it wasn't worth trying.
+static bool spin_take(adaptive_mutex_t *mutex, uint32_t *spins)
+{
+    *spins = 0;
+    TaskHandle_t owner = mutex->owner;
+    // A holder that isn't running won't release within any sensible spin.
+    if (owner == NULL || eTaskGetState(owner) != eRunning) {
+        return false;
+    }
+    uint32_t limit = 2 * mutex->stats.spin_estimate + ADAPTIVE_MUTEX_SPIN_MIN;
+    if (limit > ADAPTIVE_MUTEX_SPIN_MAX) {
+        limit = ADAPTIVE_MUTEX_SPIN_MAX;
+    }
+    while (*spins < limit) {
+        (*spins)++;
+        // The owner is cleared just before the give, so try from then on.
+        if (mutex->owner == NULL && xSemaphoreTake(mutex->handle, 0) == pdTRUE) {
+            return true;
+        }
+        tight_loop_contents();
+    }
+    return false;
+}
+#endif
+
+BaseType_t HOT_PATH_FUNC(adaptive_mutex_take)(adaptive_mutex_t *mutex, TickType_t timeout)
+{
+    bool contended = false;
+    bool spun = false;
+    uint32_t spins = 0;
+
+    if (xSemaphoreTake(mutex->handle, 0) != pdTRUE) {
+        contended = true;
+#if configNUMBER_OF_CORES > 1
+        if (timeout) {
+            spun = spin_take(mutex, &spins);
+        }
+#endif
+        if (!spun && xSemaphoreTake(mutex->handle, timeout) != pdTRUE) {
+            taskENTER_CRITICAL();
+            mutex->stats.timeouts++;
+            taskEXIT_CRITICAL();
+            return pdFALSE;
+        }
+    }
+
+    // From here on the lock serializes the stats.
+    mutex->owner = xTaskGetCurrentTaskHandle();
+    adaptive_mutex_stats_t *stats = &mutex->stats;
+    stats->acquisitions++;
+    stats->spins_total += spins;
+    if (spun) {
+        stats->spin_acquired++;
+        int32_t error = (int32_t)spins - (int32_t)stats->spin_estimate;
+        stats->spin_estimate += error / 8;
+    } else if (contended) {
+        stats->blocked++;
+        if (spins) {
+            // Spun to the limit and lost: the holds got longer.
+            stats->spin_estimate -= stats->spin_estimate / 4;
+        }
+    }
+    return pdTRUE;
+}
+
+void HOT_PATH_FUNC(adaptive_mutex_give)(adaptive_mutex_t *mutex)
+{
+    mutex->owner = NULL;
+    xSemaphoreGive(mutex->handle);
+}
+
+void adaptive_mutex_get_stats(const adaptive_mutex_t *mutex, adaptive_mutex_stats_t *stats)
+{
+    taskENTER_CRITICAL();
+    *stats = mutex->stats;
+    taskEXIT_CRITICAL();
+}
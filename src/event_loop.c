@@ -0,0 +1,83 @@
+#include "event_loop.h"
+#include "pico/time.h"
+#include "ram_placement.h"
+
+static void HOT_PATH_FUNC(handler_do_work)(async_context_t *context, async_when_pending_worker_t *worker)
+{
+    event_handler_t *handler = (event_handler_t *)worker;
+    uint32_t posted = handler->posted;
+    uint32_t events = posted - handler->handled;
+    handler->handled = posted;
+    if (events) {
+        handler->callback(handler->user_data, events);
+    }
+}
+
+static void timer_do_work(async_context_t *context, async_at_time_worker_t *worker)
+{
+    event_timer_t *timer = (event_timer_t *)worker;
+    // Re-arm from the scheduled time, not now, so callbacks don't drift.
+    async_context_add_at_time_worker_at(context, worker,
+                                        delayed_by_ms(worker->next_time, timer->period_ms));
+    timer->callback(timer->user_data, 1);
+}
+
+bool event_loop_init(event_loop_t *loop, UBaseType_t priority, configSTACK_DEPTH_TYPE stack_size)
+{
+    async_context_freertos_config_t config = async_context_freertos_default_config();
+    config.task_priority = priority;
+    config.task_stack_size = stack_size;
+    if (!async_context_freertos_init(&loop->context, &config)) {
+        return false;
+    }
+    loop->lock = spin_lock_instance(spin_lock_claim_unused(true));
+    return true;
+}
+
+void event_loop_deinit(event_loop_t *loop)
+{
+    async_context_deinit(&loop->context.core);
+    spin_lock_unclaim(spin_lock_get_num(loop->lock));
+}
+
+bool event_loop_add_handler(event_loop_t *loop, event_handler_t *handler,
+                            event_callback_t callback, void *user_data)
+{
+    handler->worker.do_work = handler_do_work;
+    handler->worker.work_pending = false;
+    handler->loop = loop;
+    handler->callback = callback;
+    handler->user_data = user_data;
+    handler->posted = 0;
+    handler->handled = 0;
+    return async_context_add_when_pending_worker(&loop->context.core, &handler->worker);
+}
+
+void event_loop_remove_handler(event_loop_t *loop, event_handler_t *handler)
+{
+    async_context_remove_when_pending_worker(&loop->context.core, &handler->worker);
+}
+
+void HOT_PATH_FUNC(event_loop_post)(event_handler_t *handler)
+{
+    // Posters may be on either core or in an ISR; the M0+ has no atomic add.
+    uint32_t save = spin_lock_blocking(handler->loop->lock);
+    handler->posted++;
+    spin_unlock(handler->loop->lock, save);
+    async_context_set_work_pending(&handler->loop->context.core, &handler->worker);
+}
+
+bool event_loop_add_timer(event_loop_t *loop, event_timer_t *timer, uint32_t period_ms,
+                          event_callback_t callback, void *user_data)
+{
+    timer->worker.do_work = timer_do_work;
+    timer->callback = callback;
+    timer->user_data = user_data;
+    timer->period_ms = period_ms;
+    return async_context_add_at_time_worker_in_ms(&loop->context.core, &timer->worker, period_ms);
+}
+
+void event_loop_remove_timer(event_loop_t *loop, event_timer_t *timer)
+{
+    async_context_remove_at_time_worker(&loop->context.core, &timer->worker);
+}
@@ -0,0 +1,106 @@
+#include "ipc_channel.h"
+#include "FreeRTOS.h"
+#include "hardware/sync.h"
+#include "pico/platform.h"
+#include "ram_placement.h"
+
+static inline uint8_t *slot_at(ipc_channel_t *ch, uint32_t index)
+{
+    return ch->slots + (index & ch->slot_mask) * ch->slot_stride;
+}
+
+void ipc_channel_init(ipc_channel_t *ch, void *storage,
+                      uint32_t slot_size, uint32_t slot_count)
+{
+    configASSERT(slot_count && (slot_count & (slot_count - 1)) == 0);
+    configASSERT(((uintptr_t)storage & 3) == 0);
+    ch->head = 0;
+    ch->tail = 0;
+    ch->consumer_waiting = false;
+    ch->producer_waiting = false;
+    ch->slot_size = slot_size;
+    ch->slot_stride = (slot_size + IPC_CHANNEL_HEADER_SIZE + 3) & ~3u;
+    ch->slot_mask = slot_count - 1;
+    ch->slots = storage;
+    sem_init(&ch->doorbell, 0, 1);
+    sem_init(&ch->space, 0, 1);
+}
+
+void *HOT_PATH_FUNC(ipc_channel_reserve)(ipc_channel_t *ch)
+{
+    uint32_t head = ch->head;
+    if (head - ch->tail > ch->slot_mask) {
+        return NULL;
+    }
+    // Don't read the slot before seeing the consumer has released it.
+    __dmb();
+    return slot_at(ch, head) + IPC_CHANNEL_HEADER_SIZE;
+}
+
+void *ipc_channel_reserve_blocking(ipc_channel_t *ch)
+{
+    void *slot;
+    while ((slot = ipc_channel_reserve(ch)) == NULL) {
+        // Same handshake as the consumer's in ipc_channel_peek, in reverse.
+        ch->producer_waiting = true;
+        __dmb();
+        slot = ipc_channel_reserve(ch);
+        if (slot) {
+            ch->producer_waiting = false;
+            break;
+        }
+        sem_acquire_blocking(&ch->space);
+        ch->producer_waiting = false;
+    }
+    return slot;
+}
+
+void HOT_PATH_FUNC(ipc_channel_commit)(ipc_channel_t *ch, uint32_t len)
+{
+    uint32_t head = ch->head;
+    *(uint32_t *)slot_at(ch, head) = len;
+    // Payload must be visible before the slot is published.
+    __dmb();
+    ch->head = head + 1;
+    // Pairs with the barrier in ipc_channel_peek: either the consumer sees the
+    // new head on its re-check, or we see it waiting and ring the doorbell.
+    __dmb();
+    if (ch->consumer_waiting) {
+        sem_release(&ch->doorbell);
+    }
+}
+
+void *HOT_PATH_FUNC(ipc_channel_peek)(ipc_channel_t *ch, uint32_t *len, uint32_t timeout_us)
+{
+    uint32_t tail = ch->tail;
+    while (ch->head == tail) {
+        ch->consumer_waiting = true;
+        __dmb();
+        if (ch->head != tail) {
+            ch->consumer_waiting = false;
+            break;
+        }
+        bool rung = sem_acquire_timeout_us(&ch->doorbell, timeout_us);
+        ch->consumer_waiting = false;
+        if (!rung && ch->head == tail) {
+            return NULL;
+        }
+    }
+    // Don't read the payload before seeing the head that published it.
+    __dmb();
+    uint8_t *slot = slot_at(ch, tail);
+    *len = *(uint32_t *)slot;
+    return slot + IPC_CHANNEL_HEADER_SIZE;
+}
+
+void HOT_PATH_FUNC(ipc_channel_release)(ipc_channel_t *ch)
+{
+    // Finish reading the slot before handing it back.
+    __dmb();
+    ch->tail = ch->tail + 1;
+    // Pairs with the barrier in ipc_channel_reserve_blocking.
+    __dmb();
+    if (ch->producer_waiting) {
+        sem_release(&ch->space);
+    }
+}
@@ -0,0 +1,270 @@
+#include <stdio.h>
+#include <string.h>
+#include "load_monitor.h"
+#include "shared_state.h"
+#include "hardware/timer.h"
+#include "pico/platform.h"
+#include "ram_placement.h"
+
+typedef struct {
+    uint32_t epoch_start;
+    uint32_t busy;          // in the current period
+    uint32_t previous;      // in the last complete period
+} load_window_state_t;
+
+typedef struct {
+    seqlock_t lock;
+    TaskHandle_t task;      // NULL when the slot is free
+    bool idle;              // one of the idle tasks
+    bool running;
+    uint32_t since_us;      // switched in at, while running
+    uint64_t total_us;
+    load_window_state_t windows[LOAD_WINDOWS];
+} task_load_t;
+
+typedef struct {
+    seqlock_t lock;
+    task_load_t *current;   // written by this core's hook only
+    bool idle;
+    uint32_t since_us;
+    uint64_t idle_us;
+    load_window_state_t windows[LOAD_WINDOWS];
+} core_load_t;
+
+static const uint32_t window_period_us[LOAD_WINDOWS] = { 1000, 100000, 1000000 };
+
+static task_load_t task_loads[LOAD_MONITOR_MAX_TASKS];
+static core_load_t core_loads[configNUMBER_OF_CORES];
+static volatile uint32_t untracked_switches;
+
+// Adds [start, end) to the window, rolling it over first if periods ended.
+// Times are taken relative to the current period so they survive the 32-bit
+// timer wrapping, as long as a window is never left alone for 71 minutes.
+static void window_charge(load_window_state_t *w, uint32_t period, uint32_t start, uint32_t end)
+{
+    uint32_t s = start - w->epoch_start;
+    uint32_t e = end - w->epoch_start;
+    if (e < period) {
+        w->busy += e - s;
+        return;
+    }
+    uint32_t ended = e / period;
+    uint32_t last_start = (ended - 1) * period;
+    uint32_t next_start = ended * period;
+    uint32_t last = ended == 1 ? w->busy : 0;
+    if (s < next_start) {
+        last += next_start - (s > last_start ? s : last_start);
+    }
+    w->previous = last;
+    w->busy = e - (s > next_start ? s : next_start);
+    w->epoch_start += next_start;
+}
+
+static void windows_charge(load_window_state_t *windows, uint32_t start, uint32_t end)
+{
+    for (int i = 0; i < LOAD_WINDOWS; i++) {
+        window_charge(&windows[i], window_period_us[i], start, end);
+    }
+}
+
+static void windows_reset(load_window_state_t *windows, uint32_t now)
+{
+    for (int i = 0; i < LOAD_WINDOWS; i++) {
+        windows[i].epoch_start = now;
+        windows[i].busy = 0;
+        windows[i].previous = 0;
+    }
+}
+
+// Fills in the snapshot from a private copy, as of now.
+static void windows_snapshot(load_window_state_t *windows, bool running, uint32_t since,
+                             uint32_t now, load_snapshot_t *snapshot)
+{
+    if (running) {
+        windows_charge(windows, since, now);
+    } else {
+        windows_charge(windows, now, now);
+    }
+    for (int i = 0; i < LOAD_WINDOWS; i++) {
+        uint32_t period = window_period_us[i];
+        uint32_t left = period - (now - windows[i].epoch_start);
+        uint64_t busy = windows[i].busy + (uint64_t)windows[i].previous * left / period;
+        uint32_t permille = (uint32_t)(busy * 1000 / period);
+        snapshot->permille[i] = permille > 1000 ? 1000 : permille;
+    }
+}
+
+static bool is_idle_task(TaskHandle_t task)
+{
+#if configNUMBER_OF_CORES > 1
+    for (BaseType_t core = 0; core < configNUMBER_OF_CORES; core++) {
+        if (task == xTaskGetIdleTaskHandleForCore(core)) {
+            return true;
+        }
+    }
+    return false;
+#else
+    return task == xTaskGetIdleTaskHandle();
+#endif
+}
+
+// Runs in the kernel with interrupts (and on SMP the kernel lock) held.
+static task_load_t *slot_for(TaskHandle_t task, uint32_t now)
+{
+    task_load_t *slot = pvTaskGetThreadLocalStoragePointer(task, LOAD_MONITOR_TLS_INDEX);
+    if (slot) {
+        return slot;
+    }
+    for (slot = task_loads; slot < task_loads + LOAD_MONITOR_MAX_TASKS; slot++) {
+        if (slot->task == NULL) {
+            seqlock_write_begin(&slot->lock);
+            slot->task = task;
+            slot->idle = is_idle_task(task);
+            slot->running = false;
+            slot->total_us = 0;
+            windows_reset(slot->windows, now);
+            seqlock_write_end(&slot->lock);
+            vTaskSetThreadLocalStoragePointer(task, LOAD_MONITOR_TLS_INDEX, slot);
+            return slot;
+        }
+    }
+    untracked_switches++;
+    return NULL;
+}
+
+void HOT_PATH_FUNC(load_monitor_switched_in)(void *task)
+{
+    uint32_t now = time_us_32();
+    core_load_t *core = &core_loads[get_core_num()];
+
+    task_load_t *previous = core->current;
+    if (previous) {
+        seqlock_write_begin(&previous->lock);
+        previous->total_us += now - previous->since_us;
+        windows_charge(previous->windows, previous->since_us, now);
+        previous->running = false;
+        seqlock_write_end(&previous->lock);
+    }
+
+    task_load_t *next = slot_for(task, now);
+    if (next) {
+        seqlock_write_begin(&next->lock);
+        next->running = true;
+        next->since_us = now;
+        seqlock_write_end(&next->lock);
+    }
+
+    seqlock_write_begin(&core->lock);
+    if (core->idle) {
+        core->idle_us += now - core->since_us;
+        windows_charge(core->windows, core->since_us, now);
+    }
+    core->current = next;
+    core->idle = next ? next->idle : is_idle_task(task);
+    core->since_us = now;
+    seqlock_write_end(&core->lock);
+}
+
+void load_monitor_task_deleted(void *task)
+{
+    task_load_t *slot = pvTaskGetThreadLocalStoragePointer(task, LOAD_MONITOR_TLS_INDEX);
+    if (slot == NULL) {
+        return;
+    }
+    // A task deleting itself is still current; its last run isn't counted.
+    for (int i = 0; i < configNUMBER_OF_CORES; i++) {
+        if (core_loads[i].current == slot) {
+            core_loads[i].current = NULL;
+        }
+    }
+    seqlock_write_begin(&slot->lock);
+    slot->task = NULL;
+    slot->running = false;
+    seqlock_write_end(&slot->lock);
+    vTaskSetThreadLocalStoragePointer(task, LOAD_MONITOR_TLS_INDEX, NULL);
+}
+
+bool load_monitor_get_task(TaskHandle_t task, load_snapshot_t *snapshot)
+{
+    task_load_t *slot = pvTaskGetThreadLocalStoragePointer(task, LOAD_MONITOR_TLS_INDEX);
+    if (slot == NULL) {
+        return false;
+    }
+    task_load_t copy;
+    uint32_t sequence;
+    do {
+        sequence = seqlock_read_begin(&slot->lock);
+        copy = *slot;
+    } while (seqlock_read_retry(&slot->lock, sequence));
+    if (copy.task != task) {
+        return false;
+    }
+
+    uint32_t now = time_us_32();
+    snapshot->total_us = copy.total_us + (copy.running ? now - copy.since_us : 0);
+    windows_snapshot(copy.windows, copy.running, copy.since_us, now, snapshot);
+    return true;
+}
+
+void load_monitor_get_core_idle(UBaseType_t core, load_snapshot_t *snapshot)
+{
+    configASSERT(core < configNUMBER_OF_CORES);
+    core_load_t *state = &core_loads[core];
+    core_load_t copy;
+    uint32_t sequence;
+    do {
+        sequence = seqlock_read_begin(&state->lock);
+        copy = *state;
+    } while (seqlock_read_retry(&state->lock, sequence));
+
+    uint32_t now = time_us_32();
+    snapshot->total_us = copy.idle_us + (copy.idle ? now - copy.since_us : 0);
+    windows_snapshot(copy.windows, copy.idle, copy.since_us, now, snapshot);
+}
+
+uint32_t load_monitor_tracked_tasks(void)
+{
+    uint32_t tracked = 0;
+    for (int i = 0; i < LOAD_MONITOR_MAX_TASKS; i++) {
+        tracked += task_loads[i].task != NULL;
+    }
+    return tracked;
+}
+
+uint32_t load_monitor_untracked(void)
+{
+    return untracked_switches;
+}
+
+void load_monitor_report(void)
+{
+    load_snapshot_t snapshot;
+    char name[configMAX_TASK_NAME_LEN];
+
+    for (UBaseType_t core = 0; core < configNUMBER_OF_CORES; core++) {
+        load_monitor_get_core_idle(core, &snapshot);
+        printf("LOAD core %lu idle   1ms %4u 100ms %4u 1s %4u permille, %llu us\n",
+               core, snapshot.permille[LOAD_WINDOW_1MS], snapshot.permille[LOAD_WINDOW_100MS],
+               snapshot.permille[LOAD_WINDOW_1S], snapshot.total_us);
+    }
+    // As in tracked_lock_report: copy out with the task pinned, print after.
+    for (int i = 0; i < LOAD_MONITOR_MAX_TASKS; i++) {
+        vTaskSuspendAll();
+        TaskHandle_t task = task_loads[i].task;
+        bool found = task && load_monitor_get_task(task, &snapshot);
+        if (found) {
+            strncpy(name, pcTaskGetName(task), sizeof(name) - 1);
+            name[sizeof(name) - 1] = '\0';
+        }
+        xTaskResumeAll();
+        if (!found) {
+            continue;
+        }
+        printf("LOAD %-16s 1ms %4u 100ms %4u 1s %4u permille, %llu us\n",
+               name, snapshot.permille[LOAD_WINDOW_1MS], snapshot.permille[LOAD_WINDOW_100MS],
+               snapshot.permille[LOAD_WINDOW_1S], snapshot.total_us);
+    }
+    if (untracked_switches) {
+        printf("LOAD %lu switches to tasks without a slot\n", untracked_switches);
+    }
+}
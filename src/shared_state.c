@@ -0,0 +1,124 @@
+#include <string.h>
+#include "shared_state.h"
+#include "FreeRTOS.h"
+#include "task.h"
+#include "hardware/sync.h"
+#include "pico/platform.h"
+#include "ram_placement.h"
+
+void seqlock_init(seqlock_t *lock)
+{
+    lock->sequence = 0;
+}
+
+void HOT_PATH_FUNC(seqlock_write_begin)(seqlock_t *lock)
+{
+    lock->sequence++;
+    __dmb();
+}
+
+void HOT_PATH_FUNC(seqlock_write_end)(seqlock_t *lock)
+{
+    __dmb();
+    lock->sequence++;
+}
+
+uint32_t HOT_PATH_FUNC(seqlock_read_begin)(const seqlock_t *lock)
+{
+    uint32_t sequence;
+    // Only possible with the writer on the other core; it finishes soon.
+    while ((sequence = lock->sequence) & 1) {
+        tight_loop_contents();
+    }
+    __dmb();
+    return sequence;
+}
+
+bool HOT_PATH_FUNC(seqlock_read_retry)(const seqlock_t *lock, uint32_t sequence)
+{
+    __dmb();
+    return lock->sequence != sequence;
+}
+
+void seqlock_write(seqlock_t *lock, void *shared, const void *value, size_t size)
+{
+    taskENTER_CRITICAL();
+    seqlock_write_begin(lock);
+    memcpy(shared, value, size);
+    seqlock_write_end(lock);
+    taskEXIT_CRITICAL();
+}
+
+uint32_t HOT_PATH_FUNC(seqlock_read)(const seqlock_t *lock, void *value, const void *shared, size_t size)
+{
+    uint32_t retries = 0;
+    for (;;) {
+        uint32_t sequence = seqlock_read_begin(lock);
+        memcpy(value, shared, size);
+        if (!seqlock_read_retry(lock, sequence)) {
+            return retries;
+        }
+        retries++;
+    }
+}
+
+void rcu_buffer_init(rcu_buffer_t *rcu, void *buffer0, void *buffer1, size_t size, const void *initial)
+{
+    rcu->buffers[0] = buffer0;
+    rcu->buffers[1] = buffer1;
+    rcu->size = size;
+    rcu->current = 0;
+    rcu->readers[0] = 0;
+    rcu->readers[1] = 0;
+    memcpy(buffer0, initial, size);
+}
+
+const void *HOT_PATH_FUNC(rcu_read_lock)(rcu_buffer_t *rcu, uint32_t *token)
+{
+    // The M0+ has no atomic increment; this is a handful of instructions.
+    taskENTER_CRITICAL();
+    uint32_t index = rcu->current;
+    rcu->readers[index]++;
+    taskEXIT_CRITICAL();
+    *token = index;
+    return rcu->buffers[index];
+}
+
+void HOT_PATH_FUNC(rcu_read_unlock)(rcu_buffer_t *rcu, uint32_t token)
+{
+    taskENTER_CRITICAL();
+    rcu->readers[token]--;
+    taskEXIT_CRITICAL();
+}
+
+void *rcu_update_begin(rcu_buffer_t *rcu)
+{
+    uint32_t next = rcu->current ^ 1;
+    // Readers that pinned this copy before the last publish may still be on
+    // it. They never block, so this only waits while they are preempted.
+    for (;;) {
+        taskENTER_CRITICAL();
+        uint32_t readers = rcu->readers[next];
+        taskEXIT_CRITICAL();
+        if (readers == 0) {
+            break;
+        }
+        vTaskDelay(1);
+    }
+    memcpy(rcu->buffers[next], rcu->buffers[rcu->current], rcu->size);
+    return rcu->buffers[next];
+}
+
+void rcu_update_end(rcu_buffer_t *rcu)
+{
+    __dmb();
+    taskENTER_CRITICAL();
+    rcu->current ^= 1;
+    taskEXIT_CRITICAL();
+}
+
+void rcu_publish(rcu_buffer_t *rcu, const void *value)
+{
+    memcpy(rcu_update_begin(rcu), value, rcu->size);
+    rcu_update_end(rcu);
+}
@@ -0,0 +1,51 @@
+#include <string.h>
+#include "tick_stats.h"
+#include "tickless_idle.h"
+#include "FreeRTOS.h"
+#include "task.h"
+#include "hardware/structs/systick.h"
+#include "pico/platform.h"
+#include "ram_placement.h"
+
+#define SYSTICK_EXCEPTION 15
+
+static tick_stats_t tick_stats;
+#if TICKLESS_IDLE
+static uint32_t tickless_sleeps_seen;
+#endif
+
+void HOT_PATH_FUNC(tick_stats_record)(void)
+{
+    if (__get_current_exception() != SYSTICK_EXCEPTION) {
+        return;
+    }
+#if TICKLESS_IDLE
+    // The period that just ended was the short one loaded on wakeup, and
+    // rvr has already been set back to a full tick.
+    uint32_t sleeps = tickless_idle_sleep_count();
+    if (sleeps != tickless_sleeps_seen) {
+        tickless_sleeps_seen = sleeps;
+        return;
+    }
+#endif
+    uint32_t cycles = systick_hw->rvr - systick_hw->cvr;
+    tick_stats.ticks++;
+    tick_stats.cycles_total += cycles;
+    if (cycles > tick_stats.cycles_max) {
+        tick_stats.cycles_max = cycles;
+    }
+}
+
+void tick_stats_get(tick_stats_t *stats)
+{
+    taskENTER_CRITICAL();
+    *stats = tick_stats;
+    taskEXIT_CRITICAL();
+}
+
+void tick_stats_reset(void)
+{
+    taskENTER_CRITICAL();
+    memset(&tick_stats, 0, sizeof(tick_stats));
+    taskEXIT_CRITICAL();
+}
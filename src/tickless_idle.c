@@ -0,0 +1,115 @@
+#include "tickless_idle.h"
+#include "FreeRTOS.h"
+#include "task.h"
+#include "hardware/sync.h"
+#include "hardware/timer.h"
+#include "hardware/structs/scb.h"
+#include "hardware/structs/systick.h"
+
+static tickless_idle_stats_t tickless_stats;
+static volatile bool tickless_enabled = true;
+
+#if TICKLESS_IDLE
+
+#if configNUMBER_OF_CORES > 1
+#error "Tickless idle only supports the single core port"
+#endif
+
+#define US_PER_TICK ( 1000000 / configTICK_RATE_HZ )
+// Keep the alarm within the 32-bit compare range of the timer.
+#define MAX_SUPPRESSED_TICKS ( UINT32_MAX / US_PER_TICK - 1 )
+
+static int wake_alarm = -1;
+static uint32_t cycles_per_tick;
+
+static void wake_alarm_callback(uint alarm_num)
+{
+    // Only here to bring the core out of WFI.
+}
+
+void vPortSuppressTicksAndSleepTimer(TickType_t xExpectedIdleTime)
+{
+    if (!tickless_enabled) {
+        return;
+    }
+    if (wake_alarm < 0) {
+        wake_alarm = hardware_alarm_claim_unused(true);
+        hardware_alarm_set_callback(wake_alarm, wake_alarm_callback);
+        cycles_per_tick = systick_hw->rvr + 1;
+    }
+    if (xExpectedIdleTime > MAX_SUPPRESSED_TICKS) {
+        xExpectedIdleTime = MAX_SUPPRESSED_TICKS;
+    }
+
+    uint32_t save = save_and_disable_interrupts();
+
+    // Freeze SysTick and note how far into the current tick we are.
+    systick_hw->csr &= ~M0PLUS_SYST_CSR_ENABLE_BITS;
+    uint64_t sleep_start = time_us_64();
+    uint32_t into_tick_us = (cycles_per_tick - systick_hw->cvr) * US_PER_TICK / cycles_per_tick;
+
+    // A task became ready or a tick is already pending: carry on ticking.
+    if ((scb_hw->icsr & M0PLUS_ICSR_PENDSTSET_BITS) ||
+        eTaskConfirmSleepModeStatus() == eAbortSleep) {
+        systick_hw->csr |= M0PLUS_SYST_CSR_ENABLE_BITS;
+        restore_interrupts(save);
+        return;
+    }
+
+    // Wake on the tick boundary where the next task times out. Any other
+    // interrupt also ends WFI, even with PRIMASK set.
+    uint64_t wake_us = sleep_start - into_tick_us + (uint64_t)xExpectedIdleTime * US_PER_TICK;
+    if (!hardware_alarm_set_target(wake_alarm, from_us_since_boot(wake_us))) {
+        __dsb();
+        __wfi();
+    }
+    hardware_alarm_cancel(wake_alarm);
+
+    uint64_t now = time_us_64();
+    uint64_t since_tick_us = now - sleep_start + into_tick_us;
+    uint32_t ticks = (uint32_t)(since_tick_us / US_PER_TICK);
+    uint32_t partial_us = (uint32_t)(since_tick_us % US_PER_TICK);
+    if (ticks > xExpectedIdleTime) {
+        ticks = xExpectedIdleTime;
+        partial_us = 0;
+    }
+
+    // Restart SysTick so the next tick lands back on the original grid.
+    uint32_t next_cycles = (US_PER_TICK - partial_us) * (cycles_per_tick / US_PER_TICK);
+    systick_hw->rvr = next_cycles ? next_cycles - 1 : 0;
+    systick_hw->cvr = 0;
+    systick_hw->csr |= M0PLUS_SYST_CSR_ENABLE_BITS;
+
+    tickless_stats.sleeps++;
+    tickless_stats.suppressed_ticks += ticks;
+    tickless_stats.slept_us += now - sleep_start;
+
+    vTaskStepTick(ticks);
+    // The short period above has been loaded by now; free run normally again.
+    systick_hw->rvr = cycles_per_tick - 1;
+    restore_interrupts(save);
+}
+
+#endif
+
+void tickless_idle_set_enabled(bool enabled)
+{
+    tickless_enabled = enabled;
+}
+
+bool tickless_idle_is_built_in(void)
+{
+    return TICKLESS_IDLE;
+}
+
+uint32_t tickless_idle_sleep_count(void)
+{
+    return *(volatile uint32_t *)&tickless_stats.sleeps;
+}
+
+void tickless_idle_get_stats(tickless_idle_stats_t *stats)
+{
+    uint32_t save = save_and_disable_interrupts();
+    *stats = tickless_stats;
+    restore_interrupts(save);
+}
@@ -0,0 +1,207 @@
+#include <stdio.h>
+#include <string.h>
+#include "tracked_lock.h"
+#include "task.h"
+#include "pico/time.h"
+#include "ram_placement.h"
+
+static tracked_lock_t *tracked_locks;
+static uint32_t report_period_ms;
+
+static inline uint32_t bucket_of(uint32_t us)
+{
+    uint32_t bucket = us ? 32 - __builtin_clz(us) : 0;
+    return bucket < TRACKED_LOCK_BUCKETS ? bucket : TRACKED_LOCK_BUCKETS - 1;
+}
+
+static inline uint32_t clamp_us(uint64_t us)
+{
+    return us > UINT32_MAX ? UINT32_MAX : (uint32_t)us;
+}
+
+static bool tracked_lock_register(tracked_lock_t *lock, const char *name, bool is_mutex)
+{
+    if (lock->handle == NULL) {
+        return false;
+    }
+    lock->name = name;
+    lock->is_mutex = is_mutex;
+    lock->acquired_us = 0;
+    memset(&lock->stats, 0, sizeof(lock->stats));
+    vQueueAddToRegistry(lock->handle, name);
+    // The registry quietly ignores adds once its configQUEUE_REGISTRY_SIZE
+    // slots are used, which would leave the lock anonymous.
+    if (pcQueueGetName(lock->handle) == NULL) {
+        printf("LOCK %s not tracked: queue registry full, raise configQUEUE_REGISTRY_SIZE\n", name);
+        vSemaphoreDelete(lock->handle);
+        lock->handle = NULL;
+        return false;
+    }
+    taskENTER_CRITICAL();
+    lock->next = tracked_locks;
+    tracked_locks = lock;
+    taskEXIT_CRITICAL();
+    return true;
+}
+
+bool tracked_lock_init_mutex(tracked_lock_t *lock, const char *name)
+{
+    lock->handle = xSemaphoreCreateMutex();
+    return tracked_lock_register(lock, name, true);
+}
+
+bool tracked_lock_init_binary(tracked_lock_t *lock, const char *name)
+{
+    lock->handle = xSemaphoreCreateBinary();
+    if (lock->handle) {
+        xSemaphoreGive(lock->handle);
+    }
+    return tracked_lock_register(lock, name, false);
+}
+
+void tracked_lock_delete(tracked_lock_t *lock)
+{
+    taskENTER_CRITICAL();
+    for (tracked_lock_t **link = &tracked_locks; *link; link = &(*link)->next) {
+        if (*link == lock) {
+            *link = lock->next;
+            break;
+        }
+    }
+    taskEXIT_CRITICAL();
+    vQueueUnregisterQueue(lock->handle);
+    vSemaphoreDelete(lock->handle);
+    lock->handle = NULL;
+}
+
+BaseType_t HOT_PATH_FUNC(tracked_lock_take)(tracked_lock_t *lock, TickType_t timeout)
+{
+    uint64_t start = time_us_64();
+    bool contended = false;
+
+    if (xSemaphoreTake(lock->handle, 0) != pdTRUE) {
+        contended = true;
+        if (xSemaphoreTake(lock->handle, timeout) != pdTRUE) {
+            taskENTER_CRITICAL();
+            lock->stats.timeouts++;
+            taskEXIT_CRITICAL();
+            return pdFALSE;
+        }
+    }
+
+    uint64_t now = time_us_64();
+    uint32_t wait = clamp_us(now - start);
+    taskENTER_CRITICAL();
+    lock->acquired_us = now;
+    lock->stats.holder = xTaskGetCurrentTaskHandle();
+    lock->stats.acquisitions++;
+    lock->stats.contended += contended;
+    lock->stats.wait_us_total += wait;
+    if (wait > lock->stats.wait_us_max) {
+        lock->stats.wait_us_max = wait;
+    }
+    lock->stats.wait_histogram[bucket_of(wait)]++;
+    taskEXIT_CRITICAL();
+    return pdTRUE;
+}
+
+void HOT_PATH_FUNC(tracked_lock_give)(tracked_lock_t *lock)
+{
+    uint32_t hold = clamp_us(time_us_64() - lock->acquired_us);
+    taskENTER_CRITICAL();
+    // A waiter that blocked on us lent us its priority, and the give below
+    // hands it back. Waiters that timed out have already taken theirs back.
+    if (lock->is_mutex && uxTaskPriorityGet(NULL) > uxTaskBasePriorityGet(NULL)) {
+        lock->stats.inheritance_boosts++;
+    }
+    lock->stats.holder = NULL;
+    lock->stats.hold_us_total += hold;
+    if (hold > lock->stats.hold_us_max) {
+        lock->stats.hold_us_max = hold;
+    }
+    lock->stats.hold_histogram[bucket_of(hold)]++;
+    taskEXIT_CRITICAL();
+    xSemaphoreGive(lock->handle);
+}
+
+tracked_lock_t *tracked_lock_find(const char *name)
+{
+    tracked_lock_t *found = NULL;
+    vTaskSuspendAll();
+    for (tracked_lock_t *lock = tracked_locks; lock; lock = lock->next) {
+        if (strcmp(lock->name, name) == 0) {
+            found = lock;
+            break;
+        }
+    }
+    xTaskResumeAll();
+    return found;
+}
+
+void tracked_lock_get_stats(const tracked_lock_t *lock, tracked_lock_stats_t *stats)
+{
+    taskENTER_CRITICAL();
+    *stats = lock->stats;
+    taskEXIT_CRITICAL();
+}
+
+void tracked_lock_reset_stats(tracked_lock_t *lock)
+{
+    taskENTER_CRITICAL();
+    TaskHandle_t holder = lock->stats.holder;
+    memset(&lock->stats, 0, sizeof(lock->stats));
+    lock->stats.holder = holder;
+    taskEXIT_CRITICAL();
+}
+
+void tracked_lock_report(void)
+{
+    tracked_lock_stats_t stats;
+    const char *name;
+    char holder[configMAX_TASK_NAME_LEN];
+
+    // Printing can block, so copy out one lock at a time with the list (and
+    // the holder task) pinned, then print with the scheduler running.
+    for (uint32_t index = 0; ; index++) {
+        vTaskSuspendAll();
+        tracked_lock_t *lock = tracked_locks;
+        for (uint32_t i = 0; lock && i < index; i++) {
+            lock = lock->next;
+        }
+        if (lock) {
+            name = lock->name;
+            tracked_lock_get_stats(lock, &stats);
+            strncpy(holder, stats.holder ? pcTaskGetName(stats.holder) : "-", sizeof(holder) - 1);
+            holder[sizeof(holder) - 1] = '\0';
+        }
+        xTaskResumeAll();
+        if (lock == NULL) {
+            break;
+        }
+
+        uint32_t acquisitions = stats.acquisitions ? stats.acquisitions : 1;
+        printf("LOCK %-12s acq %7lu cont %6lu (%3lu%%) timeouts %4lu boosts %5lu "
+               "wait avg %5lu max %6lu us, hold avg %5lu max %6lu us, holder %s\n",
+               name, stats.acquisitions, stats.contended,
+               stats.contended * 100 / acquisitions, stats.timeouts, stats.inheritance_boosts,
+               (uint32_t)(stats.wait_us_total / acquisitions), stats.wait_us_max,
+               (uint32_t)(stats.hold_us_total / acquisitions), stats.hold_us_max,
+               holder);
+    }
+}
+
+static void report_task(void *params)
+{
+    for (;;) {
+        vTaskDelay(pdMS_TO_TICKS(report_period_ms));
+        tracked_lock_report();
+    }
+}
+
+TaskHandle_t tracked_lock_start_report_task(uint32_t period_ms, UBaseType_t priority)
+{
+    TaskHandle_t task = NULL;
+    report_period_ms = period_ms;
+    xTaskCreate(report_task, "LockReport", configMINIMAL_STACK_SIZE, NULL, priority, &task);
+    return task;
+}
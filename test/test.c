@@ -5,9 +5,27 @@
 #include <stdint.h>
 #include <unity.h>
 #include "unity_config.h"
+#include "test_results.h"
 #include "semphr.h"
 #include "busy.h"
 #include <stdlib.h>
+#include <string.h>
+#include "queue.h"
+#include "stream_buffer.h"
+#include "pico/multicore.h"
+#include "hardware/sync.h"
+#include "ipc_channel.h"
+#include "ram_placement.h"
+#include "event_loop.h"
+#include "tickless_idle.h"
+#include "tracked_lock.h"
+#include "shared_state.h"
+#include "load_monitor.h"
+#include "tick_stats.h"
+#include "adaptive_mutex.h"
+#include "hardware/clocks.h"
+#include "hardware/structs/systick.h"
+#include "hardware/structs/xip_ctrl.h"
 
 #define TEST_RUNNER_PRIORITY      ( tskIDLE_PRIORITY + 10UL )
 #define LOWER_TASK_PRIORITY     ( tskIDLE_PRIORITY + 1UL )
@@ -21,9 +39,37 @@
 // Uncomment for verbose output
 // #define TEST_VERBOSE
 
-void setUp(void) {}
+// The scheduling tests expect one core. On SMP their tasks and the runner are
+// created pinned to core 0, so core 1 only runs tasks a test puts there.
+static BaseType_t create_task(TaskFunction_t task, const char *name, configSTACK_DEPTH_TYPE stack,
+                              void *params, UBaseType_t priority, TaskHandle_t *handle) {
+#if configNUMBER_OF_CORES > 1
+    return xTaskCreateAffinitySet(task, name, stack, params, priority, 1 << 0, handle);
+#else
+    return xTaskCreate(task, name, stack, params, priority, handle);
+#endif
+}
+
+void setUp(void) {
+    test_results_test_start();
+}
+
+// One idle task per core on SMP.
+static bool is_idle_task(TaskHandle_t task) {
+#if configNUMBER_OF_CORES > 1
+    for (BaseType_t core = 0; core < configNUMBER_OF_CORES; core++) {
+        if (task == xTaskGetIdleTaskHandleForCore(core)) {
+            return true;
+        }
+    }
+    return false;
+#else
+    return task == xTaskGetIdleTaskHandle();
+#endif
+}
 
 void tearDown(void) {
+    test_results_test_end();
     // List tasks that are still running and delete leftover tasks
     UBaseType_t task_count = uxTaskGetNumberOfTasks();
     TaskStatus_t tasks[task_count];
@@ -41,12 +87,11 @@ void tearDown(void) {
         printf("END OF TASK LIST\n----------------------------\n");
         #endif
         // Save a set of safe tasks
-        TaskHandle_t idle = xTaskGetIdleTaskHandle();
         TaskHandle_t runner = xTaskGetCurrentTaskHandle();
         TaskHandle_t timer = xTaskGetHandle("Tmr Svc");
         // Delete all leftover tasks
         for(int i = 0; i < task_count; i++) {
-            if(tasks[i].xHandle == idle ||
+            if(is_idle_task(tasks[i].xHandle) ||
                tasks[i].xHandle == runner ||
                tasks[i].xHandle == timer)
             {
@@ -95,7 +140,7 @@ uint32_t percent_difference(uint32_t a, uint32_t b) {
     return ((hi - lo) * 100) / hi;
 }
 
-void higher_prio_task(void *params) {
+void HOT_PATH_FUNC(higher_prio_task)(void *params) {
     SemaphoreHandle_t lock = (*(SemaphoreHandle_t*)params);
     while(1) {
         xSemaphoreTake(lock, 0xffff);
@@ -110,7 +155,7 @@ void medium_prio_task(void *params) {
     }
 }
 
-void lower_prio_task(void *params) {
+void HOT_PATH_FUNC(lower_prio_task)(void *params) {
     SemaphoreHandle_t lock = (*(SemaphoreHandle_t*)params);
     while (1) {
         xSemaphoreTake(lock, 0xffff);
@@ -125,13 +170,13 @@ void test_priority_inversion() {
     TaskHandle_t lower_task;
     TaskHandle_t medium_task;
     TaskHandle_t higher_task;
-    xTaskCreate(lower_prio_task, "LowerPrioTask",
+    create_task(lower_prio_task, "LowerPrioTask",
                 LOWER_TASK_STACK_SIZE, (void *)&lock, LOWER_TASK_PRIORITY, &lower_task);
     // Delay to allow LowerPrioTask to acquire lock
     vTaskDelay(pdMS_TO_TICKS(1));
-    xTaskCreate(higher_prio_task, "HigherPrioTask",
+    create_task(higher_prio_task, "HigherPrioTask",
                 HIGHER_TASK_STACK_SIZE, (void *)&lock, HIGHER_TASK_PRIORITY, &higher_task);
-    xTaskCreate(medium_prio_task, "MediumPrioTask",
+    create_task(medium_prio_task, "MediumPrioTask",
                 MEDIUM_TASK_STACK_SIZE, NULL, MEDIUM_TASK_PRIORITY, &medium_task);
 
     // Block for 1ms to allow HigherPrioTask & MediumPrioTask to run
@@ -204,13 +249,13 @@ void test_priority_inversion_with_mutex() {
     TaskHandle_t lower_task;
     TaskHandle_t medium_task;
     TaskHandle_t higher_task;
-    xTaskCreate(lower_prio_task, "LowerPrioTask",
+    create_task(lower_prio_task, "LowerPrioTask",
                 LOWER_TASK_STACK_SIZE, (void *)&lock, LOWER_TASK_PRIORITY, &lower_task);
     // Delay to allow LowerPrioTask to obtain lock
     vTaskDelay(pdMS_TO_TICKS(1));
-    xTaskCreate(higher_prio_task, "HigherPrioTask",
+    create_task(higher_prio_task, "HigherPrioTask",
                 HIGHER_TASK_STACK_SIZE, (void *)&lock, HIGHER_TASK_PRIORITY, &higher_task);
-    xTaskCreate(medium_prio_task, "MediumPrioTask",
+    create_task(medium_prio_task, "MediumPrioTask",
                 MEDIUM_TASK_STACK_SIZE, NULL, MEDIUM_TASK_PRIORITY, &medium_task);
 
     // Block for 1ms to allow HigherPrioTask & MediumPrioTask to run
@@ -296,9 +341,9 @@ void test_same_priority_busy_busy(void) {
     TaskHandle_t task1;
     TaskHandle_t task2;
 
-    xTaskCreate(busy_busy, "task 1",
+    create_task(busy_busy, "task 1",
                 LOWER_TASK_STACK_SIZE, NULL, LOWER_TASK_PRIORITY, &task1);
-    xTaskCreate(busy_busy, "task 2",
+    create_task(busy_busy, "task 2",
                 LOWER_TASK_STACK_SIZE, NULL, LOWER_TASK_PRIORITY, &task2);
 
     #ifdef TEST_VERBOSE            
@@ -343,9 +388,9 @@ void test_same_priority_busy_yield(void) {
     TaskHandle_t task1;
     TaskHandle_t task2;
 
-    xTaskCreate(busy_yield, "task 1",
+    create_task(busy_yield, "task 1",
                 LOWER_TASK_STACK_SIZE, NULL, LOWER_TASK_PRIORITY, &task1);
-    xTaskCreate(busy_yield, "task 2",
+    create_task(busy_yield, "task 2",
                 LOWER_TASK_STACK_SIZE, NULL, LOWER_TASK_PRIORITY, &task2);
 
     #ifdef TEST_VERBOSE            
@@ -390,9 +435,9 @@ void test_same_priority_busy_yield_and_busy(void) {
     TaskHandle_t task1;
     TaskHandle_t task2;
 
-    xTaskCreate(busy_busy, "task 1",
+    create_task(busy_busy, "task 1",
                 LOWER_TASK_STACK_SIZE, NULL, LOWER_TASK_PRIORITY, &task1);
-    xTaskCreate(busy_yield, "task 2",
+    create_task(busy_yield, "task 2",
                 LOWER_TASK_STACK_SIZE, NULL, LOWER_TASK_PRIORITY, &task2);
 
     #ifdef TEST_VERBOSE            
@@ -434,10 +479,10 @@ void test_different_priority_busy_busy_high_first(void) {
     TaskHandle_t task1;
     TaskHandle_t task2;
 
-    xTaskCreate(busy_busy, "task 1",
+    create_task(busy_busy, "task 1",
                 HIGHER_TASK_STACK_SIZE, NULL, HIGHER_TASK_PRIORITY, &task1);
     vTaskDelay(pdMS_TO_TICKS(1));
-    xTaskCreate(busy_busy, "task 2",
+    create_task(busy_busy, "task 2",
                 LOWER_TASK_STACK_SIZE, NULL, LOWER_TASK_PRIORITY, &task2);
 
     #ifdef TEST_VERBOSE            
@@ -478,10 +523,10 @@ void test_different_priority_busy_busy_low_first(void) {
     TaskHandle_t task1;
     TaskHandle_t task2;
 
-    xTaskCreate(busy_busy, "task 1",
+    create_task(busy_busy, "task 1",
                 LOWER_TASK_STACK_SIZE, NULL, LOWER_TASK_PRIORITY, &task1);
     vTaskDelay(1);
-    xTaskCreate(busy_busy, "task 2",
+    create_task(busy_busy, "task 2",
                 HIGHER_TASK_STACK_SIZE, NULL, HIGHER_TASK_PRIORITY, &task2);
 
     #ifdef TEST_VERBOSE            
@@ -522,10 +567,10 @@ void test_different_priority_busy_yield_high_first(void) {
     TaskHandle_t task1;
     TaskHandle_t task2;
 
-    xTaskCreate(busy_yield, "task 1",
+    create_task(busy_yield, "task 1",
                 HIGHER_TASK_STACK_SIZE, NULL, HIGHER_TASK_PRIORITY, &task1);
     vTaskDelay(pdMS_TO_TICKS(1));
-    xTaskCreate(busy_yield, "task 2",
+    create_task(busy_yield, "task 2",
                 LOWER_TASK_STACK_SIZE, NULL, LOWER_TASK_PRIORITY, &task2);
 
     #ifdef TEST_VERBOSE            
@@ -566,10 +611,10 @@ void test_different_priority_busy_yield_low_first(void) {
     TaskHandle_t task1;
     TaskHandle_t task2;
 
-    xTaskCreate(busy_yield, "task 1",
+    create_task(busy_yield, "task 1",
                 LOWER_TASK_STACK_SIZE, NULL, LOWER_TASK_PRIORITY, &task1);
     vTaskDelay(pdMS_TO_TICKS(1));
-    xTaskCreate(busy_yield, "task 2",
+    create_task(busy_yield, "task 2",
                 HIGHER_TASK_STACK_SIZE, NULL, HIGHER_TASK_PRIORITY, &task2);
 
     #ifdef TEST_VERBOSE            
@@ -604,11 +649,1120 @@ void test_different_priority_busy_yield_low_first(void) {
     vTaskDelay(pdMS_TO_TICKS(1));
 }
 
+#ifndef RENODE_SIMULATION
+#define RENODE_SIMULATION 0
+#endif
+
+// Inter-core messaging benchmark: FreeRTOS queue, stream buffer and the SPSC
+// channel, with the channel fed both by a task and by bare-metal core 1.
+#define IPC_BENCH_MESSAGES 1000
+#define IPC_BENCH_DEPTH 16
+#define IPC_SMALL_MESSAGE 32
+#define IPC_LARGE_MESSAGE 256
+#define IPC_BENCH_TIMEOUT_US 1000000
+
+typedef struct {
+    uint32_t seq;
+    uint64_t sent_us;
+} Ipc_Message_Header;
+
+typedef struct {
+    uint32_t received;
+    uint32_t out_of_order;
+    uint64_t start_us;
+    uint64_t latency_sum_us;
+    uint64_t latency_max_us;
+} Ipc_Bench_Result;
+
+static ipc_channel_t ipc_channel;
+static uint8_t ipc_channel_storage[IPC_CHANNEL_STORAGE_SIZE(IPC_LARGE_MESSAGE, IPC_BENCH_DEPTH)] __attribute__((aligned(4)));
+static QueueHandle_t ipc_queue;
+static StreamBufferHandle_t ipc_stream;
+static volatile size_t ipc_message_size;
+static uint8_t ipc_tx_buffer[IPC_LARGE_MESSAGE] __attribute__((aligned(8)));
+static uint8_t ipc_rx_buffer[IPC_LARGE_MESSAGE] __attribute__((aligned(8)));
+
+// Fills a message in place; the timestamp is taken last so latency only
+// covers the transport.
+static void ipc_fill_message(uint8_t *msg, uint32_t seq, size_t size) {
+    memset(msg + sizeof(Ipc_Message_Header), (uint8_t)seq, size - sizeof(Ipc_Message_Header));
+    Ipc_Message_Header hdr = { .seq = seq, .sent_us = time_us_64() };
+    memcpy(msg, &hdr, sizeof(hdr));
+}
+
+static void ipc_record(Ipc_Bench_Result *result, const uint8_t *msg, size_t size) {
+    uint64_t now = time_us_64();
+    Ipc_Message_Header hdr;
+    memcpy(&hdr, msg, sizeof(hdr));
+    // The header is 16 bytes with padding; anything after it is the payload.
+    bool payload_ok = size <= sizeof(hdr) || msg[size - 1] == (uint8_t)hdr.seq;
+    if (hdr.seq != result->received || !payload_ok) {
+        result->out_of_order++;
+    }
+    uint64_t latency = now - hdr.sent_us;
+    result->latency_sum_us += latency;
+    if (latency > result->latency_max_us) {
+        result->latency_max_us = latency;
+    }
+    result->received++;
+}
+
+static void ipc_report(const char *name, const Ipc_Bench_Result *result, size_t size) {
+    uint64_t elapsed = time_us_64() - result->start_us;
+    uint32_t rate = elapsed ? (uint64_t)result->received * 1000000 / elapsed : 0;
+    uint32_t avg = result->received ? result->latency_sum_us / result->received : 0;
+    printf("IPC %-20s %4u B: %7lu msg/s, latency avg %4lu us, max %4llu us\n",
+           name, (unsigned)size, rate, avg, result->latency_max_us);
+    test_results_value(rate, "%s %u msg/s", name, (unsigned)size);
+    test_results_value(avg, "%s %u avg us", name, (unsigned)size);
+    test_results_value(result->latency_max_us, "%s %u max us", name, (unsigned)size);
+    TEST_ASSERT_EQUAL_UINT32_MESSAGE(IPC_BENCH_MESSAGES, result->received, "Messages were lost.");
+    TEST_ASSERT_EQUAL_UINT32_MESSAGE(0, result->out_of_order, "Messages arrived out of order or corrupted.");
+}
+
+void ipc_queue_producer(void *params) {
+    for (uint32_t i = 0; i < IPC_BENCH_MESSAGES; i++) {
+        ipc_fill_message(ipc_tx_buffer, i, ipc_message_size);
+        xQueueSend(ipc_queue, ipc_tx_buffer, portMAX_DELAY);
+    }
+    vTaskSuspend(NULL);
+}
+
+void ipc_stream_producer(void *params) {
+    for (uint32_t i = 0; i < IPC_BENCH_MESSAGES; i++) {
+        ipc_fill_message(ipc_tx_buffer, i, ipc_message_size);
+        xStreamBufferSend(ipc_stream, ipc_tx_buffer, ipc_message_size, portMAX_DELAY);
+    }
+    vTaskSuspend(NULL);
+}
+
+static void ipc_channel_produce(void) {
+    for (uint32_t i = 0; i < IPC_BENCH_MESSAGES; i++) {
+        uint8_t *msg = ipc_channel_reserve_blocking(&ipc_channel);
+        ipc_fill_message(msg, i, ipc_message_size);
+        ipc_channel_commit(&ipc_channel, ipc_message_size);
+    }
+}
+
+void ipc_channel_producer(void *params) {
+    ipc_channel_produce();
+    vTaskSuspend(NULL);
+}
+
+// On SMP the producer runs on core 1 and the consumer (the runner) on core 0,
+// so every transport is measured handing messages across the cores.
+static void ipc_start_producer(TaskFunction_t producer_task, TaskHandle_t *producer) {
+#if configNUMBER_OF_CORES > 1
+    vTaskCoreAffinitySet(NULL, 1 << 0);
+    xTaskCreateAffinitySet(producer_task, "IpcProducer", LOWER_TASK_STACK_SIZE, NULL,
+                           LOWER_TASK_PRIORITY, 1 << 1, producer);
+#else
+    xTaskCreate(producer_task, "IpcProducer",
+                LOWER_TASK_STACK_SIZE, NULL, LOWER_TASK_PRIORITY, producer);
+#endif
+}
+
+static void bench_queue(size_t size) {
+    Ipc_Bench_Result result = {0};
+    TaskHandle_t producer;
+    ipc_message_size = size;
+    ipc_queue = xQueueCreate(IPC_BENCH_DEPTH, size);
+    TEST_ASSERT_NOT_NULL(ipc_queue);
+    result.start_us = time_us_64();
+    ipc_start_producer(ipc_queue_producer, &producer);
+    for (uint32_t i = 0; i < IPC_BENCH_MESSAGES; i++) {
+        if (xQueueReceive(ipc_queue, ipc_rx_buffer, pdMS_TO_TICKS(IPC_BENCH_TIMEOUT_US / 1000)) != pdTRUE) {
+            break;
+        }
+        ipc_record(&result, ipc_rx_buffer, size);
+    }
+    vTaskDelete(producer);
+    vQueueDelete(ipc_queue);
+    ipc_report("queue", &result, size);
+}
+
+static void bench_stream_buffer(size_t size) {
+    Ipc_Bench_Result result = {0};
+    TaskHandle_t producer;
+    ipc_message_size = size;
+    // Trigger at a whole message so the receiver wakes once per message.
+    ipc_stream = xStreamBufferCreate(IPC_BENCH_DEPTH * size, size);
+    TEST_ASSERT_NOT_NULL(ipc_stream);
+    result.start_us = time_us_64();
+    ipc_start_producer(ipc_stream_producer, &producer);
+    for (uint32_t i = 0; i < IPC_BENCH_MESSAGES; i++) {
+        if (xStreamBufferReceive(ipc_stream, ipc_rx_buffer, size, pdMS_TO_TICKS(IPC_BENCH_TIMEOUT_US / 1000)) != size) {
+            break;
+        }
+        ipc_record(&result, ipc_rx_buffer, size);
+    }
+    vTaskDelete(producer);
+    vStreamBufferDelete(ipc_stream);
+    ipc_report("stream buffer", &result, size);
+}
+
+static void bench_channel_consume(Ipc_Bench_Result *result, size_t size) {
+    for (uint32_t i = 0; i < IPC_BENCH_MESSAGES; i++) {
+        uint32_t len;
+        uint8_t *msg = ipc_channel_peek(&ipc_channel, &len, IPC_BENCH_TIMEOUT_US);
+        if (msg == NULL) {
+            break;
+        }
+        if (len != size) {
+            result->out_of_order++;
+        }
+        ipc_record(result, msg, size);
+        ipc_channel_release(&ipc_channel);
+    }
+}
+
+static void bench_channel_task(size_t size) {
+    Ipc_Bench_Result result = {0};
+    TaskHandle_t producer;
+    ipc_message_size = size;
+    ipc_channel_init(&ipc_channel, ipc_channel_storage, size, IPC_BENCH_DEPTH);
+    result.start_us = time_us_64();
+    ipc_start_producer(ipc_channel_producer, &producer);
+    bench_channel_consume(&result, size);
+    vTaskDelete(producer);
+    ipc_report("channel (task)", &result, size);
+}
+
+static volatile bool ipc_core1_done;
+
+// Runs on core 1. The flag only goes up once the last commit, including its
+// doorbell release and the spin lock inside it, is finished.
+static void ipc_core1_entry(void) {
+    ipc_channel_produce();
+    __dmb();
+    ipc_core1_done = true;
+    for (;;) {
+        __wfe();
+    }
+}
+
+static void bench_channel_core1(size_t size) {
+#if RENODE_SIMULATION
+    // The Renode platform keeps cpu1 halted, so the launch would never return.
+    printf("IPC %-20s %4u B: skipped, core 1 is halted in the simulator\n", "channel (core 1)", (unsigned)size);
+#elif configNUMBER_OF_CORES > 1
+    // The scheduler owns core 1, the channel is covered by the task bench.
+    printf("IPC %-20s %4u B: skipped, core 1 runs the scheduler\n", "channel (core 1)", (unsigned)size);
+#else
+    Ipc_Bench_Result result = {0};
+    ipc_message_size = size;
+    ipc_channel_init(&ipc_channel, ipc_channel_storage, size, IPC_BENCH_DEPTH);
+    ipc_core1_done = false;
+    // Core 1 may still be parked from a previous run.
+    multicore_reset_core1();
+    result.start_us = time_us_64();
+    multicore_launch_core1(ipc_core1_entry);
+    bench_channel_consume(&result, size);
+    // Don't reset core 1 in the middle of a commit. If messages were lost it
+    // may be stuck waiting for a slot, so give up after the bench timeout.
+    uint64_t deadline = time_us_64() + IPC_BENCH_TIMEOUT_US;
+    while (!ipc_core1_done && time_us_64() < deadline) {
+        vTaskDelay(1);
+    }
+    multicore_reset_core1();
+    ipc_report("channel (core 1)", &result, size);
+#endif
+}
+
+void test_ipc_small_messages(void) {
+    bench_queue(IPC_SMALL_MESSAGE);
+    bench_stream_buffer(IPC_SMALL_MESSAGE);
+    bench_channel_task(IPC_SMALL_MESSAGE);
+    bench_channel_core1(IPC_SMALL_MESSAGE);
+}
+
+void test_ipc_large_messages(void) {
+    bench_queue(IPC_LARGE_MESSAGE);
+    bench_stream_buffer(IPC_LARGE_MESSAGE);
+    bench_channel_task(IPC_LARGE_MESSAGE);
+    bench_channel_core1(IPC_LARGE_MESSAGE);
+}
+
+// XIP cache benchmark: wakeup latency with the XIP cache warm vs. flushed,
+// for a semaphore give and for the tick interrupt. Build with
+// -DHOT_PATHS_IN_RAM=ON to compare against the kernel running from SRAM.
+#define XIP_BENCH_ITERATIONS 200
+
+typedef struct {
+    uint32_t max_cycles;
+    uint64_t sum_cycles;
+} Xip_Bench_Result;
+
+static SemaphoreHandle_t xip_signal;
+static volatile uint32_t xip_wake_stamp;
+
+// Linker symbols bounding the initialized RAM image, which includes code
+// copied out of flash at boot.
+extern char __data_start__[];
+extern char __data_end__[];
+
+static void xip_flush(void) {
+    xip_ctrl_hw->flush = 1;
+    while (!(xip_ctrl_hw->stat & XIP_STAT_FLUSH_READY_BITS)) {;}
+}
+
+// SysTick counts down at the core clock and reloads every tick.
+static uint32_t systick_elapsed(uint32_t start, uint32_t end) {
+    return start >= end ? start - end : start + (systick_hw->rvr + 1) - end;
+}
+
+static void xip_record(Xip_Bench_Result *result, uint32_t cycles) {
+    result->sum_cycles += cycles;
+    if (cycles > result->max_cycles) {
+        result->max_cycles = cycles;
+    }
+}
+
+static void xip_report(const char *name, const Xip_Bench_Result *result) {
+    uint32_t mhz = clock_get_hz(clk_sys) / 1000000;
+    uint32_t avg = (uint32_t)(result->sum_cycles / XIP_BENCH_ITERATIONS);
+    printf("XIP %-18s avg %6lu cycles (%5lu ns), max %6lu cycles (%5lu ns)\n", name,
+           avg, avg * 1000 / mhz, result->max_cycles, result->max_cycles * 1000 / mhz);
+    test_results_value(avg, "%s avg", name);
+    test_results_value(result->max_cycles, "%s max", name);
+}
+
+void HOT_PATH_FUNC(xip_waiter_task)(void *params) {
+    for (;;) {
+        xSemaphoreTake(xip_signal, portMAX_DELAY);
+        xip_wake_stamp = systick_hw->cvr;
+    }
+}
+
+static void bench_give_to_wake(Xip_Bench_Result *result, bool flush) {
+    for (int i = 0; i < XIP_BENCH_ITERATIONS; i++) {
+        if (flush) {
+            xip_flush();
+        }
+        uint32_t start = systick_hw->cvr;
+        // The waiter has higher priority, so it runs before Give returns.
+        xSemaphoreGive(xip_signal);
+        xip_record(result, systick_elapsed(start, xip_wake_stamp));
+    }
+}
+
+static void bench_tick_to_wake(Xip_Bench_Result *result, bool flush) {
+    for (int i = 0; i < XIP_BENCH_ITERATIONS; i++) {
+        if (flush) {
+            xip_flush();
+        }
+        vTaskDelay(1);
+        // The tick fired when SysTick reloaded, so this is everything from
+        // the interrupt up to this task running again.
+        xip_record(result, systick_hw->rvr - systick_hw->cvr);
+    }
+}
+
+void test_xip_cache_latency(void) {
+    Xip_Bench_Result give_warm = {0}, give_cold = {0}, tick_warm = {0}, tick_cold = {0};
+    TaskHandle_t waiter;
+
+#if RENODE_SIMULATION
+    // The Renode platform has no XIP_CTRL block, so a flush never completes.
+    TEST_IGNORE_MESSAGE("XIP cache is not modelled in the simulator.");
+#endif
+    xip_signal = xSemaphoreCreateBinary();
+    TEST_ASSERT_NOT_NULL(xip_signal);
+    create_task(xip_waiter_task, "XipWaiter",
+                HIGHER_TASK_STACK_SIZE, NULL, TEST_RUNNER_PRIORITY + 1, &waiter);
+
+    bench_give_to_wake(&give_warm, false);
+    bench_give_to_wake(&give_cold, true);
+    bench_tick_to_wake(&tick_warm, false);
+    bench_tick_to_wake(&tick_cold, true);
+
+    vTaskDelete(waiter);
+    vSemaphoreDelete(xip_signal);
+
+    printf("XIP hot paths in RAM: %s, initialized RAM image %u bytes\n",
+           HOT_PATHS_IN_RAM ? "yes" : "no", (unsigned)(__data_end__ - __data_start__));
+    xip_report("give->wake warm", &give_warm);
+    xip_report("give->wake flushed", &give_cold);
+    xip_report("tick->wake warm", &tick_warm);
+    xip_report("tick->wake flushed", &tick_cold);
+    // No ordering between warm and flushed is asserted: with the hot paths in
+    // SRAM the two are expected to match to within noise.
+}
+
+// Event loop benchmark: the same set of handlers run as one task each, the
+// way the lab tasks are written, and as workers multiplexed onto a single
+// async_context task.
+#define EVENT_BENCH_HANDLERS 8
+#define EVENT_BENCH_ROUNDS 500
+#define EVENT_HANDLER_PRIORITY ( TEST_RUNNER_PRIORITY - 1 )
+#define EVENT_HANDLER_STACK_SIZE configMINIMAL_STACK_SIZE
+
+typedef struct {
+    uint64_t posted_us;
+    TaskHandle_t task;
+} Event_Bench_Handler;
+
+typedef struct {
+    uint64_t start_us;
+    uint64_t latency_sum_us;
+    uint64_t latency_max_us;
+    uint32_t handled;
+    size_t heap_bytes;
+} Event_Bench_Result;
+
+static Event_Bench_Handler event_bench_handlers[EVENT_BENCH_HANDLERS];
+static Event_Bench_Result event_bench_result;
+static SemaphoreHandle_t event_bench_done;
+static uint32_t event_bench_remaining;
+static event_loop_t event_loop;
+static event_handler_t event_handlers[EVENT_BENCH_HANDLERS];
+
+static void event_bench_handle(Event_Bench_Handler *handler) {
+    uint64_t latency = time_us_64() - handler->posted_us;
+    bool last;
+    // Handler tasks share a priority and can be time sliced mid-update.
+    taskENTER_CRITICAL();
+    event_bench_result.latency_sum_us += latency;
+    if (latency > event_bench_result.latency_max_us) {
+        event_bench_result.latency_max_us = latency;
+    }
+    event_bench_result.handled++;
+    last = --event_bench_remaining == 0;
+    taskEXIT_CRITICAL();
+    if (last) {
+        xSemaphoreGive(event_bench_done);
+    }
+}
+
+void event_handler_task(void *params) {
+    Event_Bench_Handler *handler = params;
+    for (;;) {
+        ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+        event_bench_handle(handler);
+    }
+}
+
+static void event_handler_callback(void *user_data, uint32_t events) {
+    event_bench_handle(user_data);
+}
+
+static void event_bench_report(const char *name) {
+    uint64_t elapsed = time_us_64() - event_bench_result.start_us;
+    uint32_t rate = elapsed ? (uint64_t)event_bench_result.handled * 1000000 / elapsed : 0;
+    uint32_t avg = event_bench_result.handled ? event_bench_result.latency_sum_us / event_bench_result.handled : 0;
+    printf("EVENT %-14s %7lu events/s, latency avg %4lu us, max %4llu us, heap %5u bytes\n", name,
+           rate, avg, event_bench_result.latency_max_us, (unsigned)event_bench_result.heap_bytes);
+    test_results_value(rate, "%s events/s", name);
+    test_results_value(avg, "%s avg us", name);
+    test_results_value(event_bench_result.latency_max_us, "%s max us", name);
+    test_results_value(event_bench_result.heap_bytes, "%s heap", name);
+    TEST_ASSERT_EQUAL_UINT32_MESSAGE(EVENT_BENCH_HANDLERS * EVENT_BENCH_ROUNDS, event_bench_result.handled,
+                                     "Events were lost.");
+}
+
+// Posts one event to every handler per round and waits for all of them.
+static void event_bench_run(void (*post)(int)) {
+    event_bench_result.start_us = time_us_64();
+    for (int round = 0; round < EVENT_BENCH_ROUNDS; round++) {
+        event_bench_remaining = EVENT_BENCH_HANDLERS;
+        for (int i = 0; i < EVENT_BENCH_HANDLERS; i++) {
+            event_bench_handlers[i].posted_us = time_us_64();
+            post(i);
+        }
+        if (xSemaphoreTake(event_bench_done, pdMS_TO_TICKS(100)) != pdTRUE) {
+            break;
+        }
+    }
+}
+
+static void event_post_task(int i) {
+    xTaskNotifyGive(event_bench_handlers[i].task);
+}
+
+static void event_post_loop(int i) {
+    event_loop_post(&event_handlers[i]);
+}
+
+void test_event_loop_vs_task_per_handler(void) {
+    event_bench_done = xSemaphoreCreateBinary();
+    TEST_ASSERT_NOT_NULL(event_bench_done);
+
+    memset(&event_bench_result, 0, sizeof(event_bench_result));
+    size_t heap_before = xPortGetFreeHeapSize();
+    for (int i = 0; i < EVENT_BENCH_HANDLERS; i++) {
+        create_task(event_handler_task, "EventHandler", EVENT_HANDLER_STACK_SIZE,
+                    &event_bench_handlers[i], EVENT_HANDLER_PRIORITY, &event_bench_handlers[i].task);
+    }
+    event_bench_result.heap_bytes = heap_before - xPortGetFreeHeapSize();
+    event_bench_run(event_post_task);
+    for (int i = 0; i < EVENT_BENCH_HANDLERS; i++) {
+        vTaskDelete(event_bench_handlers[i].task);
+    }
+    event_bench_report("task/handler");
+    // Let the idle task free the deleted stacks before measuring again.
+    vTaskDelay(pdMS_TO_TICKS(1));
+
+    memset(&event_bench_result, 0, sizeof(event_bench_result));
+    heap_before = xPortGetFreeHeapSize();
+    TEST_ASSERT_TRUE(event_loop_init(&event_loop, EVENT_HANDLER_PRIORITY, EVENT_HANDLER_STACK_SIZE));
+    for (int i = 0; i < EVENT_BENCH_HANDLERS; i++) {
+        event_loop_add_handler(&event_loop, &event_handlers[i], event_handler_callback, &event_bench_handlers[i]);
+    }
+    event_bench_result.heap_bytes = heap_before - xPortGetFreeHeapSize();
+    event_bench_run(event_post_loop);
+    for (int i = 0; i < EVENT_BENCH_HANDLERS; i++) {
+        event_loop_remove_handler(&event_loop, &event_handlers[i]);
+    }
+    event_loop_deinit(&event_loop);
+    event_bench_report("event loop");
+
+    vSemaphoreDelete(event_bench_done);
+    vTaskDelay(pdMS_TO_TICKS(1));
+}
+
+static void event_timer_callback(void *user_data, uint32_t events) {
+    (*(volatile uint32_t *)user_data)++;
+}
+
+// prediction: a 2 ms timer fires about 10 times in 20 ms
+void test_event_loop_timer(void) {
+    volatile uint32_t fired = 0;
+    event_timer_t timer;
+
+    TEST_ASSERT_TRUE(event_loop_init(&event_loop, EVENT_HANDLER_PRIORITY, EVENT_HANDLER_STACK_SIZE));
+    TEST_ASSERT_TRUE(event_loop_add_timer(&event_loop, &timer, 2, event_timer_callback, (void *)&fired));
+    vTaskDelay(pdMS_TO_TICKS(21));
+    event_loop_remove_timer(&event_loop, &timer);
+    event_loop_deinit(&event_loop);
+
+    TEST_ASSERT_TRUE_MESSAGE(fired >= 9 && fired <= 11, "Periodic timer fired the wrong number of times.");
+    vTaskDelay(pdMS_TO_TICKS(1));
+}
+
+// Tickless idle benchmark: tick interrupt rate, idle fraction and wakeup
+// jitter of a periodic task, with the tick running and with it suppressed.
+#define TICKLESS_BENCH_PERIOD_MS 10
+#define TICKLESS_BENCH_PERIODS 50
+
+static void bench_tickless(bool enabled) {
+    tickless_idle_stats_t before, after;
+    int64_t max_jitter_us = 0;
+
+    tickless_idle_set_enabled(enabled);
+    // Start on a tick boundary so every wakeup has the same phase.
+    vTaskDelay(1);
+    TickType_t start_tick = xTaskGetTickCount();
+    TickType_t last_wake = start_tick;
+    uint64_t start_us = time_us_64();
+    uint64_t idle_start = ulTaskGetIdleRunTimeCounter();
+    tickless_idle_get_stats(&before);
+
+    for (int i = 1; i <= TICKLESS_BENCH_PERIODS; i++) {
+        vTaskDelayUntil(&last_wake, pdMS_TO_TICKS(TICKLESS_BENCH_PERIOD_MS));
+        int64_t jitter = (int64_t)(time_us_64() - start_us) - (int64_t)i * TICKLESS_BENCH_PERIOD_MS * 1000;
+        if (jitter < 0) {
+            jitter = -jitter;
+        }
+        if (jitter > max_jitter_us) {
+            max_jitter_us = jitter;
+        }
+    }
+
+    uint64_t elapsed_us = time_us_64() - start_us;
+    uint64_t idle_us = ulTaskGetIdleRunTimeCounter() - idle_start;
+    tickless_idle_get_stats(&after);
+    uint32_t ticks = xTaskGetTickCount() - start_tick;
+    uint32_t suppressed = after.suppressed_ticks - before.suppressed_ticks;
+    uint32_t sleeps = after.sleeps - before.sleeps;
+
+    const char *mode = enabled ? "on" : "off";
+    uint32_t tick_rate = (uint64_t)(ticks - suppressed) * 1000000 / elapsed_us;
+    uint32_t sleep_rate = (uint64_t)sleeps * 1000000 / elapsed_us;
+    uint32_t idle_percent = idle_us * 100 / elapsed_us;
+    printf("TICKLESS %-8s tick irq/s %5lu, sleeps/s %5lu, idle %3lu%%, max wake jitter %4lld us\n",
+           mode, tick_rate, sleep_rate, idle_percent, max_jitter_us);
+    test_results_value(tick_rate, "%s tick irq/s", mode);
+    test_results_value(sleep_rate, "%s sleeps/s", mode);
+    test_results_value(idle_percent, "%s idle %%", mode);
+    test_results_value(max_jitter_us, "%s max jitter us", mode);
+
+    // Stepped ticks must keep the tick count in line with wall time.
+    TEST_ASSERT_TRUE_MESSAGE(ticks * (1000000 / configTICK_RATE_HZ) <= elapsed_us + 2000 &&
+                             ticks * (1000000 / configTICK_RATE_HZ) + 2000 >= elapsed_us,
+                             "Tick count drifted from wall time.");
+    if (enabled) {
+        TEST_ASSERT_TRUE_MESSAGE(suppressed > 0, "No ticks were suppressed while idle.");
+    } else {
+        TEST_ASSERT_EQUAL_UINT32(0, suppressed);
+    }
+}
+
+void test_tickless_idle(void) {
+    bench_tickless(false);
+    if (tickless_idle_is_built_in()) {
+        bench_tickless(true);
+    } else {
+        printf("TICKLESS not built in, configure with -DTICKLESS_IDLE=ON to compare\n");
+    }
+    tickless_idle_set_enabled(true);
+}
+
+void tracked_higher_task(void *params) {
+    tracked_lock_t *lock = params;
+    while(1) {
+        tracked_lock_take(lock, 0xffff);
+        for(uint32_t i = 0; i < 10000; i++) {;}
+        tracked_lock_give(lock);
+    }
+}
+
+void tracked_lower_task(void *params) {
+    tracked_lock_t *lock = params;
+    while (1) {
+        tracked_lock_take(lock, 0xffff);
+        for(uint32_t i = 0; i < 10000; i++) {;}
+        tracked_lock_give(lock);
+    }
+}
+
+// Same setup as test_priority_inversion_with_mutex, with the lock tracked.
+// prediction: the higher task contends once, boosting the lower task, and
+// then owns the lock for the rest of the run
+void test_tracked_lock_contention(void) {
+    static tracked_lock_t lock;
+    tracked_lock_stats_t stats;
+    TaskHandle_t lower_task;
+    TaskHandle_t higher_task;
+
+    TEST_ASSERT_TRUE(tracked_lock_init_mutex(&lock, "inversion"));
+    TEST_ASSERT_EQUAL_MESSAGE(&lock, tracked_lock_find("inversion"), "Lock not found by name.");
+    TEST_ASSERT_NOT_NULL_MESSAGE(pcQueueGetName(lock.handle), "Lock not in the queue registry.");
+    TEST_ASSERT_EQUAL_MESSAGE(0, strcmp(pcQueueGetName(lock.handle), "inversion"), "Lock registered under the wrong name.");
+
+    create_task(tracked_lower_task, "LowerPrioTask",
+                LOWER_TASK_STACK_SIZE, &lock, LOWER_TASK_PRIORITY, &lower_task);
+    vTaskDelay(pdMS_TO_TICKS(1));
+    create_task(tracked_higher_task, "HigherPrioTask",
+                HIGHER_TASK_STACK_SIZE, &lock, HIGHER_TASK_PRIORITY, &higher_task);
+    vTaskDelay(pdMS_TO_TICKS(10));
+
+    tracked_lock_report();
+    tracked_lock_get_stats(&lock, &stats);
+
+    vTaskDelete(lower_task);
+    vTaskDelete(higher_task);
+    tracked_lock_delete(&lock);
+
+    test_results_value(stats.acquisitions, "acquisitions");
+    test_results_value(stats.contended, "contended");
+    test_results_value(stats.inheritance_boosts, "inheritance boosts");
+
+    TEST_ASSERT_TRUE_MESSAGE(stats.acquisitions > 2, "Lock was barely used.");
+    TEST_ASSERT_TRUE_MESSAGE(stats.contended >= 1, "Higher priority task never waited.");
+    TEST_ASSERT_TRUE_MESSAGE(stats.inheritance_boosts >= 1, "Lower priority holder was never boosted.");
+    TEST_ASSERT_TRUE_MESSAGE(stats.holder == lower_task || stats.holder == higher_task || stats.holder == NULL,
+                             "Holder is not one of the tasks.");
+    uint32_t waits = 0;
+    for (int i = 0; i < TRACKED_LOCK_BUCKETS; i++) {
+        waits += stats.wait_histogram[i];
+    }
+    TEST_ASSERT_EQUAL_UINT32(stats.acquisitions, waits);
+    TEST_ASSERT_NULL(tracked_lock_find("inversion"));
+
+    vTaskDelay(pdMS_TO_TICKS(1));
+}
+
+// Shared state readers: the inversion setup with the higher task as a reader
+// of state the lower task writes, under a mutex, a seqlock and RCU.
+#define SHARED_WORDS 16
+#define SHARED_READS_PER_TICK 100
+
+typedef struct {
+    uint32_t word[SHARED_WORDS];
+} Shared_State;
+
+typedef enum { SHARED_MUTEX, SHARED_SEQLOCK, SHARED_RCU } Shared_Mode;
+
+typedef struct {
+    uint32_t reads;
+    uint32_t torn;
+    uint32_t retries;
+    uint32_t max_cycles;
+    uint64_t sum_cycles;
+} Shared_Bench_Result;
+
+static Shared_Mode shared_mode;
+static Shared_State shared_plain;
+static Shared_State shared_copies[2];
+static SemaphoreHandle_t shared_mutex;
+static seqlock_t shared_seqlock;
+static rcu_buffer_t shared_rcu;
+static Shared_Bench_Result shared_result;
+
+static void shared_init(Shared_Mode mode) {
+    Shared_State initial = {0};
+    shared_mode = mode;
+    shared_plain = initial;
+    shared_mutex = xSemaphoreCreateMutex();
+    seqlock_init(&shared_seqlock);
+    rcu_buffer_init(&shared_rcu, &shared_copies[0], &shared_copies[1], sizeof(Shared_State), &initial);
+    memset(&shared_result, 0, sizeof(shared_result));
+}
+
+static void shared_read(Shared_State *out) {
+    uint32_t token;
+    switch (shared_mode) {
+    case SHARED_MUTEX:
+        xSemaphoreTake(shared_mutex, portMAX_DELAY);
+        *out = shared_plain;
+        xSemaphoreGive(shared_mutex);
+        break;
+    case SHARED_SEQLOCK:
+        shared_result.retries += seqlock_read(&shared_seqlock, out, &shared_plain, sizeof(Shared_State));
+        break;
+    case SHARED_RCU:
+        *out = *(const Shared_State *)rcu_read_lock(&shared_rcu, &token);
+        rcu_read_unlock(&shared_rcu, token);
+        break;
+    }
+}
+
+// Writes every word with the same value, a word at a time, so any reader
+// that sees mixed values caught the writer halfway.
+static void shared_write(uint32_t value) {
+    Shared_State next;
+    for (int i = 0; i < SHARED_WORDS; i++) {
+        next.word[i] = value;
+    }
+    switch (shared_mode) {
+    case SHARED_MUTEX:
+        xSemaphoreTake(shared_mutex, portMAX_DELAY);
+        for (int i = 0; i < SHARED_WORDS; i++) {
+            shared_plain.word[i] = value;
+            for(uint32_t j = 0; j < 1000; j++) {;}
+        }
+        xSemaphoreGive(shared_mutex);
+        break;
+    case SHARED_SEQLOCK:
+        seqlock_write(&shared_seqlock, &shared_plain, &next, sizeof(next));
+        break;
+    case SHARED_RCU:
+        rcu_publish(&shared_rcu, &next);
+        break;
+    }
+}
+
+static bool shared_is_torn(const Shared_State *state) {
+    for (int i = 1; i < SHARED_WORDS; i++) {
+        if (state->word[i] != state->word[0]) {
+            return true;
+        }
+    }
+    return false;
+}
+
+void shared_writer_task(void *params) {
+    for (uint32_t value = 1; ; value++) {
+        shared_write(value);
+    }
+}
+
+// Reads back to back, like higher_prio_task, and never gives up the CPU.
+void shared_busy_reader_task(void *params) {
+    Shared_State state;
+    while (1) {
+        shared_read(&state);
+        shared_result.torn += shared_is_torn(&state);
+    }
+}
+
+// Reads in bursts once per tick so the writer gets to run in between.
+void shared_reader_task(void *params) {
+    Shared_State state;
+    while (1) {
+        for (int i = 0; i < SHARED_READS_PER_TICK; i++) {
+            uint32_t start = systick_hw->cvr;
+            shared_read(&state);
+            uint32_t cycles = systick_elapsed(start, systick_hw->cvr);
+            shared_result.reads++;
+            shared_result.torn += shared_is_torn(&state);
+            shared_result.sum_cycles += cycles;
+            if (cycles > shared_result.max_cycles) {
+                shared_result.max_cycles = cycles;
+            }
+        }
+        vTaskDelay(1);
+    }
+}
+
+// prediction: the reader never blocks, so it keeps running and the medium
+// task gets nothing, even though the lower task was mid-write
+static void run_reader_inversion(Shared_Mode mode) {
+    TaskHandle_t lower_task;
+    TaskHandle_t medium_task;
+    TaskHandle_t higher_task;
+    TaskStatus_t medium_prio_status, higher_prio_status;
+
+    shared_init(mode);
+    create_task(shared_writer_task, "LowerPrioTask",
+                LOWER_TASK_STACK_SIZE, NULL, LOWER_TASK_PRIORITY, &lower_task);
+    vTaskDelay(pdMS_TO_TICKS(1));
+    create_task(shared_busy_reader_task, "HigherPrioTask",
+                HIGHER_TASK_STACK_SIZE, NULL, HIGHER_TASK_PRIORITY, &higher_task);
+    create_task(medium_prio_task, "MediumPrioTask",
+                MEDIUM_TASK_STACK_SIZE, NULL, MEDIUM_TASK_PRIORITY, &medium_task);
+    vTaskDelay(pdMS_TO_TICKS(1));
+
+    vTaskGetInfo(medium_task, &medium_prio_status, pdFALSE, eInvalid);
+    vTaskGetInfo(higher_task, &higher_prio_status, pdFALSE, eInvalid);
+    uint64_t last_runntime_medium = medium_prio_status.ulRunTimeCounter;
+    uint64_t last_runntime_higher = higher_prio_status.ulRunTimeCounter;
+
+    for(int i = 0; i < 5; i ++) {
+        vTaskDelay(pdMS_TO_TICKS(1));
+
+        vTaskGetInfo(medium_task, &medium_prio_status, pdFALSE, eInvalid);
+        vTaskGetInfo(higher_task, &higher_prio_status, pdFALSE, eInvalid);
+
+        TEST_ASSERT_TRUE_MESSAGE(higher_prio_status.ulRunTimeCounter > last_runntime_higher,
+                                 "Reader should keep running, it never waits on the writer.");
+        TEST_ASSERT_TRUE_MESSAGE(medium_prio_status.ulRunTimeCounter == last_runntime_medium,
+                                 "Medium priority runntime shouldn't change while the reader runs.");
+        TEST_ASSERT_TRUE_MESSAGE(higher_prio_status.eCurrentState == eReady,
+                                 "Reader should never be blocked.");
+
+        last_runntime_medium = medium_prio_status.ulRunTimeCounter;
+        last_runntime_higher = higher_prio_status.ulRunTimeCounter;
+    }
+    TEST_ASSERT_EQUAL_UINT32_MESSAGE(0, shared_result.torn, "Reader saw a half written state.");
+
+    vTaskDelete(lower_task);
+    vTaskDelete(medium_task);
+    vTaskDelete(higher_task);
+    vSemaphoreDelete(shared_mutex);
+    vTaskDelay(pdMS_TO_TICKS(1));
+}
+
+void test_priority_inversion_seqlock(void) {
+    run_reader_inversion(SHARED_SEQLOCK);
+}
+
+void test_priority_inversion_rcu(void) {
+    run_reader_inversion(SHARED_RCU);
+}
+
+static void bench_shared_state(Shared_Mode mode, const char *name) {
+    TaskHandle_t writer;
+    TaskHandle_t reader;
+
+    shared_init(mode);
+    uint64_t start_us = time_us_64();
+    create_task(shared_writer_task, "SharedWriter",
+                LOWER_TASK_STACK_SIZE, NULL, LOWER_TASK_PRIORITY, &writer);
+    create_task(shared_reader_task, "SharedReader",
+                HIGHER_TASK_STACK_SIZE, NULL, HIGHER_TASK_PRIORITY, &reader);
+    vTaskDelay(pdMS_TO_TICKS(50));
+    vTaskDelete(reader);
+    vTaskDelete(writer);
+    uint64_t elapsed_us = time_us_64() - start_us;
+    vSemaphoreDelete(shared_mutex);
+
+    printf("SHARED %-8s %7llu reads/s, latency avg %5lu max %6lu cycles, retries %4lu, torn %lu\n",
+           name, (uint64_t)shared_result.reads * 1000000 / elapsed_us,
+           shared_result.reads ? (uint32_t)(shared_result.sum_cycles / shared_result.reads) : 0,
+           shared_result.max_cycles, shared_result.retries, shared_result.torn);
+    test_results_value((int32_t)((uint64_t)shared_result.reads * 1000000 / elapsed_us), "%s reads/s", name);
+    test_results_value(shared_result.max_cycles, "%s max cycles", name);
+    TEST_ASSERT_TRUE_MESSAGE(shared_result.reads > 0, "Reader never ran.");
+    TEST_ASSERT_EQUAL_UINT32_MESSAGE(0, shared_result.torn, "Reader saw a half written state.");
+    vTaskDelay(pdMS_TO_TICKS(1));
+}
+
+void test_shared_state_readers(void) {
+    bench_shared_state(SHARED_MUTEX, "mutex");
+    bench_shared_state(SHARED_SEQLOCK, "seqlock");
+    bench_shared_state(SHARED_RCU, "rcu");
+}
+
+// prediction: a busy task below the runner takes (nearly) the whole core
+// while the runner sleeps, and once it is deleted the core goes idle
+void test_load_monitor(void) {
+    load_snapshot_t busy;
+    load_snapshot_t idle;
+    TaskStatus_t status;
+    TaskHandle_t task;
+
+    create_task(busy_busy, "LoadBusy",
+                LOWER_TASK_STACK_SIZE, NULL, LOWER_TASK_PRIORITY, &task);
+    vTaskDelay(pdMS_TO_TICKS(200));
+    TEST_ASSERT_TRUE_MESSAGE(load_monitor_get_task(task, &busy), "Busy task not tracked.");
+    load_monitor_get_core_idle(0, &idle);
+    vTaskGetInfo(task, &status, pdFALSE, eRunning);
+    load_monitor_report();
+    // The handle dangles once the task is deleted, so check the slot count.
+    uint32_t tracked = load_monitor_tracked_tasks();
+    vTaskDelete(task);
+
+    printf("LOAD busy 100ms %u permille, idle %u permille, %llu us vs run time counter %llu us\n",
+           busy.permille[LOAD_WINDOW_100MS], idle.permille[LOAD_WINDOW_100MS],
+           busy.total_us, status.ulRunTimeCounter);
+    test_results_value(busy.permille[LOAD_WINDOW_100MS], "busy 100ms permille");
+    test_results_value(idle.permille[LOAD_WINDOW_100MS], "idle 100ms permille");
+    TEST_ASSERT_TRUE_MESSAGE(busy.permille[LOAD_WINDOW_100MS] > 900, "Busy task under 90% load.");
+    TEST_ASSERT_TRUE_MESSAGE(idle.permille[LOAD_WINDOW_100MS] < 100, "Core idle while a task was busy.");
+    uint64_t counted = status.ulRunTimeCounter;
+    uint64_t diff = busy.total_us > counted ? busy.total_us - counted : counted - busy.total_us;
+    TEST_ASSERT_TRUE_MESSAGE(diff < 2000, "Total time disagrees with the kernel run time stats.");
+    TEST_ASSERT_EQUAL_UINT32_MESSAGE(tracked - 1, load_monitor_tracked_tasks(), "Deleted task still tracked.");
+
+    vTaskDelay(pdMS_TO_TICKS(150));
+    load_monitor_get_core_idle(0, &idle);
+    TEST_ASSERT_TRUE_MESSAGE(idle.permille[LOAD_WINDOW_100MS] > 900, "Core busy with nothing to run.");
+    TEST_ASSERT_TRUE_MESSAGE(idle.permille[LOAD_WINDOW_1MS] > 900, "Core busy in the last millisecond.");
+}
+
+// Scheduler scalability: workers spread over priority levels, some blocking
+// on a 1 tick delay and the rest always ready (yielding between bursts of
+// work), while the runner sits above them all at the top priority.
+#define SCALE_RUN_MS 100
+#define SCALE_PROBES 200
+#define SCALE_WORK_ITERATIONS 2000
+#define SCALE_MAX_TASKS 24
+
+static const uint32_t scale_task_counts[] = { 4, 12, 24 };
+static const uint32_t scale_levels[] = { 1, 8, 24 };
+static const uint32_t scale_blocking_percent[] = { 0, 50, 100 };
+
+typedef struct {
+    uint32_t created;
+    uint32_t create_cycles_max;
+    uint64_t create_cycles_total;
+    size_t heap_bytes;
+    tick_stats_t ticks;
+    uint32_t switch_cycles_max;
+    uint64_t switch_cycles_total;
+} Scale_Result;
+
+static Scale_Result scale_result;
+static TaskHandle_t scale_runner;
+static volatile uint32_t scale_block_stamp;
+
+static void scale_worker(void *params) {
+    bool blocks = params != NULL;
+    for (;;) {
+        for (volatile uint32_t i = 0; i < SCALE_WORK_ITERATIONS; i++) {;}
+        if (blocks) {
+            vTaskDelay(1);
+        } else {
+            taskYIELD();
+        }
+    }
+}
+
+// Runs as soon as the runner blocks, so the stamp difference is the switch
+// from a blocking call to the highest priority ready task.
+static void scale_probe(void *params) {
+    for (;;) {
+        uint32_t cycles = systick_elapsed(scale_block_stamp, systick_hw->cvr);
+        scale_result.switch_cycles_total += cycles;
+        if (cycles > scale_result.switch_cycles_max) {
+            scale_result.switch_cycles_max = cycles;
+        }
+        xTaskNotifyGive(scale_runner);
+    }
+}
+
+static void bench_scale(uint32_t tasks, uint32_t levels, uint32_t blocking_percent) {
+    TaskHandle_t workers[SCALE_MAX_TASKS];
+    TaskHandle_t probe;
+
+    memset(&scale_result, 0, sizeof(scale_result));
+    size_t heap_before = xPortGetFreeHeapSize();
+    for (uint32_t i = 0; i < tasks; i++) {
+        bool blocks = i * 100 < blocking_percent * tasks;
+        uint32_t start = systick_hw->cvr;
+        BaseType_t created = create_task(scale_worker, "ScaleWorker", LOWER_TASK_STACK_SIZE,
+                                         blocks ? (void *)1 : NULL, LOWER_TASK_PRIORITY + i % levels,
+                                         &workers[i]);
+        uint32_t cycles = systick_elapsed(start, systick_hw->cvr);
+        if (created != pdPASS) {
+            break;
+        }
+        scale_result.created++;
+        scale_result.create_cycles_total += cycles;
+        if (cycles > scale_result.create_cycles_max) {
+            scale_result.create_cycles_max = cycles;
+        }
+    }
+    scale_result.heap_bytes = heap_before - xPortGetFreeHeapSize();
+
+    tick_stats_reset();
+    vTaskDelay(pdMS_TO_TICKS(SCALE_RUN_MS));
+    tick_stats_get(&scale_result.ticks);
+
+    create_task(scale_probe, "ScaleProbe", LOWER_TASK_STACK_SIZE, NULL,
+                LOWER_TASK_PRIORITY + levels, &probe);
+    for (int i = 0; i < SCALE_PROBES; i++) {
+        scale_block_stamp = systick_hw->cvr;
+        ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+    }
+    vTaskDelete(probe);
+    for (uint32_t i = 0; i < scale_result.created; i++) {
+        vTaskDelete(workers[i]);
+    }
+
+    uint32_t created = scale_result.created ? scale_result.created : 1;
+    uint32_t ticks = scale_result.ticks.ticks ? scale_result.ticks.ticks : 1;
+    uint32_t create_avg = (uint32_t)(scale_result.create_cycles_total / created);
+    uint32_t tick_avg = (uint32_t)(scale_result.ticks.cycles_total / ticks);
+    uint32_t switch_avg = (uint32_t)(scale_result.switch_cycles_total / SCALE_PROBES);
+    printf("SCALE %5lu %6lu %5lu%% | %6lu %6lu | %6lu %6lu | %6lu %6lu | %6u %5u\n",
+           scale_result.created, levels, blocking_percent,
+           tick_avg, scale_result.ticks.cycles_max,
+           switch_avg, scale_result.switch_cycles_max,
+           create_avg, scale_result.create_cycles_max,
+           (unsigned)scale_result.heap_bytes, (unsigned)(scale_result.heap_bytes / created));
+    test_results_value(tick_avg, "t%lu l%lu b%lu tick", tasks, levels, blocking_percent);
+    test_results_value(switch_avg, "t%lu l%lu b%lu switch", tasks, levels, blocking_percent);
+    test_results_value(create_avg, "t%lu l%lu b%lu create", tasks, levels, blocking_percent);
+    test_results_value(scale_result.heap_bytes / created, "t%lu l%lu b%lu heap/task", tasks, levels, blocking_percent);
+
+    TEST_ASSERT_EQUAL_UINT32_MESSAGE(tasks, scale_result.created, "Ran out of heap for the workers.");
+    TEST_ASSERT_TRUE_MESSAGE(scale_result.ticks.ticks > 0, "No tick was measured.");
+}
+
+// Prints one row per configuration, times in CPU cycles
+void test_scheduler_scalability(void) {
+    printf("SCALE tasks levels block | tick avg    max | switch avg  max | create avg  max |   heap  /task\n");
+    vTaskPrioritySet(NULL, configMAX_PRIORITIES - 1);
+    scale_runner = xTaskGetCurrentTaskHandle();
+    for (int t = 0; t < count_of(scale_task_counts); t++) {
+        for (int l = 0; l < count_of(scale_levels); l++) {
+            for (int b = 0; b < count_of(scale_blocking_percent); b++) {
+                bench_scale(scale_task_counts[t], scale_levels[l], scale_blocking_percent[b]);
+                // Let the idle task free the deleted workers.
+                vTaskDelay(pdMS_TO_TICKS(5));
+            }
+        }
+    }
+    vTaskPrioritySet(NULL, TEST_RUNNER_PRIORITY);
+}
+
+// Spin-then-block against the standard mutex: two workers at the same
+// priority (one per core on SMP) take the lock, hold it for a fixed loop and
+// do as much work again outside it.
+#define SPIN_BENCH_MS 50
+
+static const uint32_t spin_hold_iterations[] = { 100, 1000, 10000 };
+
+typedef struct {
+    bool adaptive;
+    uint32_t hold;
+    SemaphoreHandle_t mutex;
+    adaptive_mutex_t adaptive_mutex;
+    uint32_t acquisitions;
+    uint32_t wait_us_max;
+    uint64_t wait_us_total;
+} Spin_Bench;
+
+static Spin_Bench spin_bench;
+
+static void spin_worker(void *params) {
+    for (;;) {
+        uint32_t start = time_us_32();
+        if (spin_bench.adaptive) {
+            adaptive_mutex_take(&spin_bench.adaptive_mutex, portMAX_DELAY);
+        } else {
+            xSemaphoreTake(spin_bench.mutex, portMAX_DELAY);
+        }
+        // Recorded under the lock, so the workers don't race on it.
+        uint32_t wait = time_us_32() - start;
+        spin_bench.acquisitions++;
+        spin_bench.wait_us_total += wait;
+        if (wait > spin_bench.wait_us_max) {
+            spin_bench.wait_us_max = wait;
+        }
+        for (volatile uint32_t i = 0; i < spin_bench.hold; i++) {;}
+        if (spin_bench.adaptive) {
+            adaptive_mutex_give(&spin_bench.adaptive_mutex);
+        } else {
+            xSemaphoreGive(spin_bench.mutex);
+        }
+        for (volatile uint32_t i = 0; i < spin_bench.hold; i++) {;}
+    }
+}
+
+static void bench_spin(bool adaptive, uint32_t hold) {
+    TaskHandle_t workers[2];
+    adaptive_mutex_stats_t stats = { 0 };
+
+    memset(&spin_bench, 0, sizeof(spin_bench));
+    spin_bench.adaptive = adaptive;
+    spin_bench.hold = hold;
+    if (adaptive) {
+        TEST_ASSERT_TRUE(adaptive_mutex_init(&spin_bench.adaptive_mutex));
+    } else {
+        spin_bench.mutex = xSemaphoreCreateMutex();
+        TEST_ASSERT_NOT_NULL(spin_bench.mutex);
+    }
+    for (int i = 0; i < 2; i++) {
+#if configNUMBER_OF_CORES > 1
+        // One worker per core.
+        xTaskCreateAffinitySet(spin_worker, "SpinWorker", LOWER_TASK_STACK_SIZE, NULL,
+                               MEDIUM_TASK_PRIORITY, 1 << i, &workers[i]);
+#else
+        xTaskCreate(spin_worker, "SpinWorker", LOWER_TASK_STACK_SIZE, NULL,
+                    MEDIUM_TASK_PRIORITY, &workers[i]);
+#endif
+    }
+    uint64_t start_us = time_us_64();
+    vTaskDelay(pdMS_TO_TICKS(SPIN_BENCH_MS));
+    vTaskDelete(workers[0]);
+    vTaskDelete(workers[1]);
+    uint64_t elapsed_us = time_us_64() - start_us;
+
+    if (adaptive) {
+        adaptive_mutex_get_stats(&spin_bench.adaptive_mutex, &stats);
+        adaptive_mutex_delete(&spin_bench.adaptive_mutex);
+    } else {
+        vSemaphoreDelete(spin_bench.mutex);
+    }
+
+    uint32_t rate = (uint32_t)((uint64_t)spin_bench.acquisitions * 1000000 / elapsed_us);
+    uint32_t acquisitions = spin_bench.acquisitions ? spin_bench.acquisitions : 1;
+    printf("SPIN %-8s hold %5lu: %7lu acq/s, wait avg %4lu max %5lu us, spun %5lu blocked %5lu estimate %4lu\n",
+           adaptive ? "adaptive" : "mutex", hold, rate,
+           (uint32_t)(spin_bench.wait_us_total / acquisitions), spin_bench.wait_us_max,
+           stats.spin_acquired, stats.blocked, stats.spin_estimate);
+    test_results_value(rate, "%s hold %lu acq/s", adaptive ? "adaptive" : "mutex", hold);
+
+    TEST_ASSERT_TRUE_MESSAGE(spin_bench.acquisitions > 2, "Workers barely got the lock.");
+#if configNUMBER_OF_CORES == 1
+    TEST_ASSERT_EQUAL_UINT32_MESSAGE(0, stats.spin_acquired, "Spun against a holder on the same core.");
+#else
+    if (adaptive && hold == spin_hold_iterations[0]) {
+        TEST_ASSERT_TRUE_MESSAGE(stats.spin_acquired > 0, "Never spun for the shortest hold on SMP.");
+    }
+#endif
+    vTaskDelay(pdMS_TO_TICKS(1));
+}
+
+// prediction: on SMP the adaptive lock wins short holds by spinning and
+// beats the mutex there, and converges on blocking for long holds; on one
+// core both behave the same
+void test_adaptive_mutex(void) {
+    for (int i = 0; i < count_of(spin_hold_iterations); i++) {
+        bench_spin(false, spin_hold_iterations[i]);
+        bench_spin(true, spin_hold_iterations[i]);
+    }
+}
+
 void runner_thread (__unused void *args)
 {
     for (;;) {
         printf("Starting test run.\n");
         UNITY_BEGIN();
+        test_results_begin();
         RUN_TEST(test_priority_inversion);
         RUN_TEST(test_priority_inversion_with_mutex);
         RUN_TEST(test_same_priority_busy_busy);
@@ -618,7 +1772,21 @@ void runner_thread (__unused void *args)
         RUN_TEST(test_different_priority_busy_busy_low_first);
         RUN_TEST(test_different_priority_busy_yield_high_first);
         RUN_TEST(test_different_priority_busy_yield_low_first);
+        RUN_TEST(test_ipc_small_messages);
+        RUN_TEST(test_ipc_large_messages);
+        RUN_TEST(test_xip_cache_latency);
+        RUN_TEST(test_event_loop_vs_task_per_handler);
+        RUN_TEST(test_event_loop_timer);
+        RUN_TEST(test_tickless_idle);
+        RUN_TEST(test_tracked_lock_contention);
+        RUN_TEST(test_priority_inversion_seqlock);
+        RUN_TEST(test_priority_inversion_rcu);
+        RUN_TEST(test_shared_state_readers);
+        RUN_TEST(test_load_monitor);
+        RUN_TEST(test_scheduler_scalability);
+        RUN_TEST(test_adaptive_mutex);
         UNITY_END();
+        test_results_done();
         sleep_ms(5000);
     }
 }
@@ -629,7 +1797,7 @@ int main (void)
     sleep_ms(10000);
     printf("Launching runner\n");
     hard_assert(cyw43_arch_init() == PICO_OK);
-    xTaskCreate(runner_thread, "TestRunner",
+    create_task(runner_thread, "TestRunner",
                 TEST_RUNNER_STACK_SIZE, NULL, TEST_RUNNER_PRIORITY, NULL);
     vTaskStartScheduler();
 	return 0;
@@ -0,0 +1,108 @@
+#include <stdarg.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <string.h>
+#include <unity.h>
+#include "test_results.h"
+#include "hardware/sync.h"
+#include "pico/time.h"
+
+// Not zeroed at boot: test_results_begin sets it up, and a reader checks
+// the magic and state before trusting anything else.
+test_results_t __attribute__((section(".uninitialized_data.test_results"))) test_results;
+
+static test_result_t *current;
+static uint32_t message_len;
+static bool capturing;
+static uint32_t run_count;
+
+void test_results_begin(void)
+{
+    test_results.state = TEST_RESULTS_EMPTY;
+    __dmb();
+    memset(test_results.tests, 0, sizeof(test_results.tests));
+    memset(test_results.values, 0, sizeof(test_results.values));
+    test_results.magic = TEST_RESULTS_MAGIC;
+    test_results.version = TEST_RESULTS_VERSION;
+    test_results.size = sizeof(test_results);
+    test_results.run = ++run_count;
+    test_results.test_count = 0;
+    test_results.value_count = 0;
+    test_results.dropped = 0;
+    current = NULL;
+    capturing = false;
+    __dmb();
+    test_results.state = TEST_RESULTS_RUNNING;
+}
+
+void test_results_test_start(void)
+{
+    if (test_results.state != TEST_RESULTS_RUNNING) {
+        return;
+    }
+    if (test_results.test_count == TEST_RESULTS_MAX_TESTS) {
+        test_results.dropped++;
+        current = NULL;
+        return;
+    }
+    current = &test_results.tests[test_results.test_count++];
+    strncpy(current->name, Unity.CurrentTestName, TEST_RESULTS_NAME_LEN - 1);
+    current->line = Unity.CurrentTestLineNumber;
+    current->first_value = test_results.value_count;
+    current->start_us = time_us_32();
+    message_len = 0;
+    capturing = true;
+}
+
+void test_results_test_end(void)
+{
+    if (current == NULL) {
+        return;
+    }
+    // Failures and ignores are flagged before tearDown runs. Unity prints
+    // the PASS line after it, which isn't worth keeping.
+    capturing = false;
+    current->duration_us = time_us_32() - current->start_us;
+    current->status = Unity.CurrentTestFailed ? TEST_RESULT_FAIL :
+                      Unity.CurrentTestIgnored ? TEST_RESULT_IGNORE : TEST_RESULT_PASS;
+}
+
+void test_results_value(int32_t value, const char *key_format, ...)
+{
+    if (current == NULL || test_results.value_count == TEST_RESULTS_MAX_VALUES) {
+        test_results.dropped++;
+        return;
+    }
+    test_value_t *entry = &test_results.values[test_results.value_count++];
+    va_list args;
+    va_start(args, key_format);
+    vsnprintf(entry->key, TEST_RESULTS_KEY_LEN, key_format, args);
+    va_end(args);
+    entry->value = value;
+    current->value_count++;
+}
+
+void test_results_output_char(char c)
+{
+    if (!capturing || message_len >= TEST_RESULTS_MESSAGE_LEN - 1 || c == '\n' || c == '\r') {
+        return;
+    }
+    current->message[message_len++] = c;
+}
+
+void test_results_done(void)
+{
+    current = NULL;
+    capturing = false;
+    __dmb();
+    test_results.state = TEST_RESULTS_COMPLETE;
+    __dmb();
+    test_results_published();
+}
+
+// Empty, but kept as a real call: the asm stops the compiler from treating
+// it as pure and dropping it.
+void __attribute__((noinline, used)) test_results_published(void)
+{
+    __asm volatile ("" ::: "memory");
+}
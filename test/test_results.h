@@ -0,0 +1,84 @@
+#ifndef TEST_RESULTS_H
+#define TEST_RESULTS_H
+
+#include <stdint.h>
+
+// Structured test results in RAM, for the simulator to read directly.
+//
+// The runner records every test (name, status, the Unity failure line,
+// start time and duration) and any values a benchmark wants to report in
+// test_results, a fixed layout block in an uninitialized RAM section. When
+// the run is over test_results_done marks the block complete and calls
+// test_results_published; Renode hooks that function, dumps the block and
+// tools/renode_results.py turns it into JUnit XML and JSON (see results.resc
+// and the results_mytest target). Nothing goes over the UART, and the layout
+// below must match the tool.
+
+#define TEST_RESULTS_MAGIC 0x53455254u     // "TRES"
+#define TEST_RESULTS_VERSION 1
+#define TEST_RESULTS_MAX_TESTS 40
+#define TEST_RESULTS_MAX_VALUES 256
+#define TEST_RESULTS_NAME_LEN 48
+#define TEST_RESULTS_MESSAGE_LEN 96
+#define TEST_RESULTS_KEY_LEN 28
+
+typedef enum {
+    TEST_RESULT_PASS,
+    TEST_RESULT_FAIL,
+    TEST_RESULT_IGNORE,
+} test_status_t;
+
+typedef enum {
+    TEST_RESULTS_EMPTY,
+    TEST_RESULTS_RUNNING,
+    TEST_RESULTS_COMPLETE,
+} test_results_state_t;
+
+typedef struct {
+    char name[TEST_RESULTS_NAME_LEN];
+    char message[TEST_RESULTS_MESSAGE_LEN];   // Unity output, the failure line
+    uint32_t status;
+    uint32_t line;                              // of the RUN_TEST
+    uint32_t start_us;
+    uint32_t duration_us;
+    uint32_t first_value;
+    uint32_t value_count;
+} test_result_t;
+
+typedef struct {
+    char key[TEST_RESULTS_KEY_LEN];
+    int32_t value;
+} test_value_t;
+
+typedef struct {
+    uint32_t magic;
+    uint32_t version;
+    uint32_t size;                  // of this struct, so readers know what to dump
+    volatile uint32_t state;
+    uint32_t run;                   // runner iteration, counting from 1
+    uint32_t test_count;
+    uint32_t value_count;
+    uint32_t dropped;               // tests and values that didn't fit
+    test_result_t tests[TEST_RESULTS_MAX_TESTS];
+    test_value_t values[TEST_RESULTS_MAX_VALUES];
+} test_results_t;
+
+extern test_results_t test_results;
+
+// Clears the block for a new run.
+void test_results_begin(void);
+// Call from setUp and tearDown, around each test.
+void test_results_test_start(void);
+void test_results_test_end(void);
+// Attaches a measured value to the running test, under a printf-style key
+// of up to TEST_RESULTS_KEY_LEN - 1 characters.
+void test_results_value(int32_t value, const char *key_format, ...)
+    __attribute__((format(printf, 2, 3)));
+// Unity output, captured into the running test's message.
+void test_results_output_char(char c);
+// Marks the run complete.
+void test_results_done(void);
+// Called by test_results_done once the block is complete. Renode hooks this.
+void test_results_published(void);
+
+#endif /* TEST_RESULTS_H */
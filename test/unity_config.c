@@ -1,5 +1,6 @@
 #include <stdio.h>
 #include "unity_config.h"
+#include "test_results.h"
 
 void unityOutputStart()
 {
@@ -8,6 +9,7 @@ void unityOutputStart()
 void unityOutputChar(char c)
 {
     putchar(c);
+    test_results_output_char(c);
 }
 
 void unityOutputFlush()
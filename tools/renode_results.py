@@ -0,0 +1,172 @@
+#!/usr/bin/env python3
+"""Test results read straight out of target RAM by Renode, no UART involved.
+
+Two steps:
+
+  hooks    Reads the addresses of test_results and test_results_published
+           from the firmware and writes a Renode script that hooks
+           test_results_published. When the runner has finished and marked
+           the block complete, the hook dumps the test_results block (see
+           test/test_results.h) as hex words and pauses the emulation.
+
+  convert  Decodes the dump into JSON and, optionally, JUnit XML. Exits with
+           1 if a test failed or there is no dump (the run didn't finish).
+
+Usage (results.resc and the results_mytest target run all three steps):
+  renode_results.py hooks build/test/mytest.elf log/test_results.hex -o log/results_hooks.resc
+  renode ... -e "... include @results.resc"
+  renode_results.py convert log/test_results.hex -o log/results.json --junit log/results.xml
+"""
+
+import argparse
+import json
+import os
+import struct
+import sys
+import xml.etree.ElementTree as ET
+
+from renode_trace import hook, read_symbols
+
+# Must match test/test_results.h.
+MAGIC = 0x53455254
+VERSION = 1
+MAX_TESTS = 40
+MAX_VALUES = 256
+NAME_LEN = 48
+MESSAGE_LEN = 96
+KEY_LEN = 28
+STATE_COMPLETE = 2
+
+HEADER = struct.Struct('<8I')
+TEST = struct.Struct('<{}s{}s6I'.format(NAME_LEN, MESSAGE_LEN))
+VALUE = struct.Struct('<{}si'.format(KEY_LEN))
+SIZE = HEADER.size + MAX_TESTS * TEST.size + MAX_VALUES * VALUE.size
+# Larger than any sane layout, so a corrupt size word can't stall Renode.
+MAX_DUMP = 0x10000
+
+STATUS = {0: 'pass', 1: 'fail', 2: 'ignore'}
+
+
+def make_hooks(args):
+    symbols = read_symbols(args.elf)
+    base = symbols['test_results']
+    body = (
+        "base = {base}\n"
+        "size = machine.SystemBus.ReadDoubleWord(base + 8)\n"
+        "if machine.SystemBus.ReadDoubleWord(base) == {magic} and size <= {max_dump}:\n"
+        "    f = open('{dump}', 'w')\n"
+        "    for offset in range(0, size, 4):\n"
+        "        f.write('%08x' % machine.SystemBus.ReadDoubleWord(base + offset) + chr(10))\n"
+        "    f.close()\n"
+        "machine.PauseAndRequestEmulationPause()"
+    ).format(base=hex(base), magic=hex(MAGIC), max_dump=hex(MAX_DUMP), dump=args.dump)
+    with open(args.output, 'w') as f:
+        f.write('# Generated by tools/renode_results.py from {}\n'.format(args.elf))
+        f.write(hook('cpu0', symbols['test_results_published'], body))
+    # A dump left over from an earlier run would hide a run that never finished.
+    if os.path.exists(args.dump):
+        os.remove(args.dump)
+
+
+def cstring(raw):
+    return raw.split(b'\0', 1)[0].decode('utf-8', 'replace')
+
+
+def decode(dump):
+    with open(dump) as f:
+        data = b''.join(struct.pack('<I', int(line, 16)) for line in f if line.strip())
+    if len(data) < HEADER.size:
+        sys.exit('{}: truncated dump'.format(dump))
+    magic, version, size, state, run, test_count, value_count, dropped = HEADER.unpack_from(data)
+    if magic != MAGIC or version != VERSION or size != SIZE or len(data) < SIZE:
+        sys.exit('{}: layout does not match test/test_results.h'.format(dump))
+    if state != STATE_COMPLETE:
+        sys.exit('{}: results block is in state {}, not complete'.format(dump, state))
+
+    values = []
+    for i in range(min(value_count, MAX_VALUES)):
+        key, value = VALUE.unpack_from(data, HEADER.size + MAX_TESTS * TEST.size + i * VALUE.size)
+        values.append((cstring(key), value))
+
+    tests = []
+    for i in range(min(test_count, MAX_TESTS)):
+        name, message, status, line, start_us, duration_us, first, count = \
+            TEST.unpack_from(data, HEADER.size + i * TEST.size)
+        tests.append({
+            'name': cstring(name),
+            'status': STATUS.get(status, 'unknown'),
+            'message': cstring(message),
+            'line': line,
+            'start_us': start_us,
+            'duration_us': duration_us,
+            'values': dict(values[first:first + count]),
+        })
+    return {'run': run, 'dropped': dropped, 'tests': tests}
+
+
+def write_junit(results, path):
+    tests = results['tests']
+    suites = ET.Element('testsuites')
+    suite = ET.SubElement(suites, 'testsuite', {
+        'name': 'mytest',
+        'tests': str(len(tests)),
+        'failures': str(sum(t['status'] == 'fail' for t in tests)),
+        'skipped': str(sum(t['status'] == 'ignore' for t in tests)),
+        'errors': '0',
+        'time': '{:.6f}'.format(sum(t['duration_us'] for t in tests) / 1e6),
+    })
+    for t in tests:
+        case = ET.SubElement(suite, 'testcase', {
+            'classname': 'mytest', 'name': t['name'], 'time': '{:.6f}'.format(t['duration_us'] / 1e6)})
+        if t['values']:
+            properties = ET.SubElement(case, 'properties')
+            for key, value in t['values'].items():
+                ET.SubElement(properties, 'property', {'name': key, 'value': str(value)})
+        if t['status'] == 'fail':
+            ET.SubElement(case, 'failure', {'message': t['message']}).text = t['message']
+        elif t['status'] == 'ignore':
+            ET.SubElement(case, 'skipped', {'message': t['message']})
+    ET.ElementTree(suites).write(path, encoding='utf-8', xml_declaration=True)
+
+
+def convert(args):
+    if not os.path.exists(args.dump):
+        print('{}: no results, the test run did not finish'.format(args.dump), file=sys.stderr)
+        sys.exit(1)
+    results = decode(args.dump)
+    with open(args.output, 'w') as f:
+        json.dump(results, f, indent=2)
+    if args.junit:
+        write_junit(results, args.junit)
+
+    tests = results['tests']
+    failed = [t['name'] for t in tests if t['status'] == 'fail']
+    print('{} tests, {} failed, {} values, {} dropped, written to {}'.format(
+        len(tests), len(failed), sum(len(t['values']) for t in tests), results['dropped'], args.output))
+    for name in failed:
+        print('FAIL {}'.format(name))
+    sys.exit(1 if failed else 0)
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    sub = parser.add_subparsers(dest='command', required=True)
+
+    hooks = sub.add_parser('hooks', help='generate the Renode hook script')
+    hooks.add_argument('elf')
+    hooks.add_argument('dump', help='file the hook writes the results block to')
+    hooks.add_argument('-o', '--output', required=True)
+    hooks.set_defaults(func=make_hooks)
+
+    conv = sub.add_parser('convert', help='convert the dump to JSON and JUnit XML')
+    conv.add_argument('dump')
+    conv.add_argument('-o', '--output', required=True, help='JSON output')
+    conv.add_argument('--junit', help='JUnit XML output')
+    conv.set_defaults(func=convert)
+
+    args = parser.parse_args()
+    args.func(args)
+
+
+if __name__ == '__main__':
+    main()
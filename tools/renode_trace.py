@@ -0,0 +1,248 @@
+#!/usr/bin/env python3
+"""Task timeline from a Renode run, with no instrumentation on the target.
+
+Two steps:
+
+  hooks    Reads symbol addresses (and the TCB layout, if the ELF has DWARF)
+           from the firmware and writes a Renode script that hooks
+           vTaskSwitchContext and the semaphore take/give entry points on
+           every core, including gives from interrupts. Each hook appends
+           one line to an event log. xQueueGenericSend also carries plain
+           queue sends, so its hook skips queues with a nonzero item size.
+
+  convert  Turns that event log into Chrome trace JSON, which Perfetto
+           (ui.perfetto.dev) and chrome://tracing open directly: one track
+           per core with a slice per task run, plus instant events for lock
+           takes and gives.
+
+vTaskSwitchContext is entered while the outgoing task is still current, so
+each hook closes the slice of the task that was running up to that point.
+
+Usage (trace.resc and the trace_mytest target run all three steps):
+  renode_trace.py hooks build/test/mytest.elf log/trace_events.log -o log/trace_hooks.resc
+  renode ... -e "... include @trace.resc"
+  renode_trace.py convert log/trace_events.log -o log/trace.json
+"""
+
+import argparse
+import json
+import shutil
+import subprocess
+import sys
+
+# Offset of pcTaskName in the TCB for this project's FreeRTOSConfig, used when
+# the ELF has no DWARF: pxTopOfStack, two 20 byte list items, uxPriority and
+# pxStack, plus xTaskRunState, uxTaskAttributes and uxCoreAffinityMask on SMP.
+DEFAULT_NAME_OFFSET = {1: 52, 2: 64}
+# Offset of uxItemSize in Queue_t: pcHead, pcWriteTo, an 8 byte union, two
+# 20 byte lists, uxMessagesWaiting and uxLength. Zero for semaphores.
+DEFAULT_ITEM_SIZE_OFFSET = 64
+TASK_NAME_LEN = 16
+QUEUE_REGISTRY_ENTRY = 8
+
+
+def read_symbols(elf):
+    """Returns {name: address} for every symbol in elf."""
+    try:
+        from elftools.elf.elffile import ELFFile
+        with open(elf, 'rb') as f:
+            symtab = ELFFile(f).get_section_by_name('.symtab')
+            return {s.name: s['st_value'] for s in symtab.iter_symbols() if s.name}
+    except ImportError:
+        pass
+    nm = shutil.which('arm-none-eabi-nm') or shutil.which('nm')
+    if nm is None:
+        sys.exit('need pyelftools or arm-none-eabi-nm to read symbols')
+    symbols = {}
+    for line in subprocess.check_output([nm, elf], text=True).splitlines():
+        parts = line.split()
+        if len(parts) == 3:
+            symbols[parts[2]] = int(parts[0], 16)
+    return symbols
+
+
+def read_symbol_sizes(elf):
+    """Returns {name: size in bytes} for every sized symbol in elf."""
+    try:
+        from elftools.elf.elffile import ELFFile
+        with open(elf, 'rb') as f:
+            symtab = ELFFile(f).get_section_by_name('.symtab')
+            return {s.name: s['st_size'] for s in symtab.iter_symbols() if s.name}
+    except ImportError:
+        pass
+    nm = shutil.which('arm-none-eabi-nm') or shutil.which('nm')
+    if nm is None:
+        sys.exit('need pyelftools or arm-none-eabi-nm to read symbols')
+    sizes = {}
+    for line in subprocess.check_output([nm, '-S', elf], text=True).splitlines():
+        parts = line.split()
+        if len(parts) == 4:
+            sizes[parts[3]] = int(parts[1], 16)
+    return sizes
+
+
+def read_member_offset(elf, struct_name, member_name):
+    """Finds the offset of struct_name.member_name from DWARF, or None."""
+    try:
+        from elftools.elf.elffile import ELFFile
+    except ImportError:
+        return None
+    with open(elf, 'rb') as f:
+        elffile = ELFFile(f)
+        if not elffile.has_dwarf_info():
+            return None
+        for cu in elffile.get_dwarf_info().iter_CUs():
+            for die in cu.iter_DIEs():
+                if (die.tag == 'DW_TAG_structure_type' and
+                        die.attributes.get('DW_AT_name') and
+                        die.attributes['DW_AT_name'].value == struct_name.encode()):
+                    for member in die.iter_children():
+                        name = member.attributes.get('DW_AT_name')
+                        if name and name.value == member_name.encode():
+                            return member.attributes['DW_AT_data_member_location'].value
+    return None
+
+
+def hook(cpu, address, body):
+    # Renode strips the triple quotes and hands the rest to IronPython.
+    return '{} AddHook {} """\n{}\n"""\n'.format(cpu, hex(address & ~1), body)
+
+
+def make_hooks(args):
+    symbols = read_symbols(args.elf)
+    smp = 'pxCurrentTCBs' in symbols
+    cores = 2 if smp else 1
+    current = symbols['pxCurrentTCBs' if smp else 'pxCurrentTCB']
+    offset = args.name_offset
+    if offset is None:
+        offset = read_member_offset(args.elf, 'tskTaskControlBlock', 'pcTaskName')
+    if offset is None:
+        offset = DEFAULT_NAME_OFFSET[cores]
+        print('no DWARF for tskTCB, assuming pcTaskName at offset {}'.format(offset), file=sys.stderr)
+    item_size = read_member_offset(args.elf, 'QueueDefinition', 'uxItemSize')
+    if item_size is None:
+        item_size = DEFAULT_ITEM_SIZE_OFFSET
+        print('no DWARF for Queue_t, assuming uxItemSize at offset {}'.format(item_size), file=sys.stderr)
+
+    # IronPython 2.7 inside Renode. chr() avoids escaping through the .resc.
+    read_name = (
+        "def name_at(p):\n"
+        "    s = ''\n"
+        "    for i in range({len}):\n"
+        "        c = machine.SystemBus.ReadByte(p + i)\n"
+        "        if c == 0: break\n"
+        "        s += chr(c)\n"
+        "    return s\n").format(len=TASK_NAME_LEN)
+    emit = (
+        "def emit(kind, core, rest):\n"
+        "    t = machine.ElapsedVirtualTime.TimeElapsed.TotalMicroseconds\n"
+        "    f = open('{log}', 'a')\n"
+        "    f.write('%s %d %d %s' % (kind, t, core, rest) + chr(10))\n"
+        "    f.close()\n").format(log=args.log)
+    registry = symbols.get('xQueueRegistry')
+    # configQUEUE_REGISTRY_SIZE, from the size of the array in the ELF.
+    registry_size = read_symbol_sizes(args.elf).get('xQueueRegistry', 0) // QUEUE_REGISTRY_ENTRY
+    lines = ['# Generated by tools/renode_trace.py from {}\n'.format(args.elf)]
+
+    for core in range(cores):
+        tcb = current + 4 * core
+        body = read_name + emit + (
+            "tcb = machine.SystemBus.ReadDoubleWord({tcb})\n"
+            "emit('SWITCH', {core}, '0x%x %s' % (tcb, name_at(tcb + {offset})))"
+        ).format(tcb=hex(tcb), core=core, offset=offset)
+        lines.append(hook('cpu{}'.format(core), symbols['vTaskSwitchContext'], body))
+
+        for kind, function in (('TAKE', 'xQueueSemaphoreTake'), ('GIVE', 'xQueueGenericSend'),
+                               ('GIVE_ISR', 'xQueueGiveFromISR')):
+            if function not in symbols:
+                continue
+            # Everything after the item size check is indented under it.
+            event = "qname = '0x%x' % queue\n"
+            if registry is not None:
+                # Use the queue registry name when the lock was registered.
+                event += (
+                    "for i in range({count}):\n"
+                    "    entry = {registry} + i * {size}\n"
+                    "    if machine.SystemBus.ReadDoubleWord(entry + 4) == queue:\n"
+                    "        qname = name_at(machine.SystemBus.ReadDoubleWord(entry))\n"
+                ).format(count=registry_size, registry=hex(registry), size=QUEUE_REGISTRY_ENTRY)
+            event += (
+                "tcb = machine.SystemBus.ReadDoubleWord({tcb})\n"
+                "emit('{kind}', {core}, '0x%x %s %s' % (tcb, qname, name_at(tcb + {offset})))"
+            ).format(tcb=hex(tcb), kind=kind, core=core, offset=offset)
+            body = read_name + emit + (
+                "queue = self.GetRegisterUnsafe(0).RawValue\n"
+                "if machine.SystemBus.ReadDoubleWord(queue + {item_size}) == 0:\n"
+            ).format(item_size=item_size)
+            body += ''.join('    ' + line + '\n' for line in event.splitlines())
+            lines.append(hook('cpu{}'.format(core), symbols[function], body))
+
+    with open(args.output, 'w') as f:
+        f.writelines(lines)
+    # Start every run with an empty event log.
+    open(args.log, 'w').close()
+
+
+def convert(args):
+    events = []
+    running = {}    # core -> (start_us, tcb, name)
+    cores = set()
+
+    with open(args.log) as f:
+        for line in f:
+            parts = line.rstrip('\n').split(' ', 4)
+            if len(parts) < 4:
+                continue
+            kind, ts, core, tcb = parts[0], int(parts[1]), int(parts[2]), parts[3]
+            cores.add(core)
+            if kind == 'SWITCH':
+                name = parts[4] if len(parts) > 4 else tcb
+                start = running.get(core)
+                # The slice that ends here belongs to the task being switched out.
+                start_us = start[0] if start else ts
+                if ts > start_us:
+                    events.append({'name': name, 'cat': 'task', 'ph': 'X', 'pid': 1, 'tid': core,
+                                   'ts': start_us, 'dur': ts - start_us, 'args': {'tcb': tcb}})
+                running[core] = (ts, tcb, name)
+            elif kind in ('TAKE', 'GIVE', 'GIVE_ISR'):
+                rest = parts[4].split(' ', 1) if len(parts) > 4 else ['?', '']
+                lock = rest[0]
+                # From an interrupt, the task is the one it interrupted.
+                task = rest[1] if len(rest) > 1 else tcb
+                action = 'give (isr)' if kind == 'GIVE_ISR' else kind.lower()
+                events.append({'name': '{} {}'.format(action, lock), 'cat': 'lock', 'ph': 'i',
+                               's': 't', 'pid': 1, 'tid': core, 'ts': ts,
+                               'args': {'task': task, 'lock': lock}})
+
+    for core in sorted(cores):
+        events.append({'name': 'thread_name', 'ph': 'M', 'pid': 1, 'tid': core,
+                       'args': {'name': 'core {}'.format(core)}})
+    events.append({'name': 'process_name', 'ph': 'M', 'pid': 1, 'args': {'name': 'RP2040 (Renode)'}})
+
+    with open(args.output, 'w') as f:
+        json.dump({'traceEvents': events, 'displayTimeUnit': 'ns'}, f)
+    print('{} events from {} cores written to {}'.format(len(events), len(cores), args.output))
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    sub = parser.add_subparsers(dest='command', required=True)
+
+    hooks = sub.add_parser('hooks', help='generate the Renode hook script')
+    hooks.add_argument('elf')
+    hooks.add_argument('log', help='event log the hooks append to')
+    hooks.add_argument('-o', '--output', required=True)
+    hooks.add_argument('--name-offset', type=int, help='offset of pcTaskName in the TCB')
+    hooks.set_defaults(func=make_hooks)
+
+    conv = sub.add_parser('convert', help='convert the event log to Chrome/Perfetto JSON')
+    conv.add_argument('log')
+    conv.add_argument('-o', '--output', required=True)
+    conv.set_defaults(func=convert)
+
+    args = parser.parse_args()
+    args.func(args)
+
+
+if __name__ == '__main__':
+    main()